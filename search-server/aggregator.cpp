@@ -0,0 +1,96 @@
+#include "search_aggregator.h"
+#include "instrumentation.h"
+#include "command_line.h"
+#include "corpus_io.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Клиент распределённого индекса. Части — через запятую, реплики части — через '|':
+//  aggregator --shards='unix:/tmp/shard0.sock|unix:/tmp/shard0b.sock,unix:/tmp/shard1.sock' --query='curly cat'
+//  aggregator --shards=... --queries=queries.txt --threads=8 --hedge-delay-ms=5
+
+vector<vector<string>> ParseShardAddresses(const string& text) {
+    vector<vector<string>> shards(1);
+    string address;
+    for (const char c : text) {
+        if (c == ',' || c == '|') {
+            shards.back().push_back(move(address));
+            address.clear();
+            if (c == ',') {
+                shards.emplace_back();
+            }
+        } else {
+            address.push_back(c);
+        }
+    }
+    shards.back().push_back(move(address));
+    return shards;
+}
+
+void ReplayQueries(const SearchAggregator& aggregator, const vector<string>& queries, int thread_count) {
+    using Clock = chrono::steady_clock;
+
+    vector<HdrHistogram> latencies(thread_count);
+    atomic<size_t> next_query = 0;
+    atomic<size_t> failed_count = 0;
+    const Clock::time_point start_time = Clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < thread_count; ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t i = next_query++; i < queries.size(); i = next_query++) {
+                const Clock::time_point begin = Clock::now();
+                try {
+                    aggregator.FindTopDocuments(queries[i]);
+                } catch (const exception&) {
+                    ++failed_count;
+                }
+                latencies[t].Add(chrono::duration_cast<chrono::nanoseconds>(Clock::now() - begin).count());
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    const double elapsed = chrono::duration<double>(Clock::now() - start_time).count();
+    HdrHistogram latency;
+    for (const HdrHistogram& histogram : latencies) {
+        latency.Merge(histogram);
+    }
+    cout << "{\"queries\": "s << queries.size() << ", \"failed\": "s << failed_count
+         << ", \"shards\": "s << aggregator.GetShardCount() << ", \"threads\": "s << thread_count
+         << ", \"qps\": "s << queries.size() / elapsed
+         << ", \"hedged_requests\": "s << aggregator.GetHedgedRequestCount()
+         << ", \"latency\": {\"p50_ns\": "s << latency.GetValueAtPercentile(50)
+         << ", \"p90_ns\": "s << latency.GetValueAtPercentile(90)
+         << ", \"p99_ns\": "s << latency.GetValueAtPercentile(99)
+         << ", \"p999_ns\": "s << latency.GetValueAtPercentile(99.9)
+         << ", \"max_ns\": "s << latency.GetMax() << "}}"s << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        const CommandLineOptions options(argc, argv, 1);
+        AggregatorOptions aggregator_options;
+        aggregator_options.hedge_delay = chrono::milliseconds(options.Get("hedge-delay-ms"s, aggregator_options.hedge_delay.count()));
+        aggregator_options.timeout = chrono::milliseconds(options.Get("timeout-ms"s, aggregator_options.timeout.count()));
+        const SearchAggregator aggregator(ParseShardAddresses(options.GetString("shards"s, "127.0.0.1:7000"s)), aggregator_options);
+
+        const string queries_path = options.GetString("queries"s, ""s);
+        if (!queries_path.empty()) {
+            const int thread_count = options.Get("threads"s, static_cast<int>(max(1u, thread::hardware_concurrency())));
+            ReplayQueries(aggregator, LoadQueries(queries_path), thread_count);
+        } else {
+            for (const Document& document : aggregator.FindTopDocuments(options.GetString("query"s, ""s))) {
+                cout << document << endl;
+            }
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,329 @@
+#include "search_server.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "random_generators.h"
+#include "instrumentation.h"
+#include "command_line.h"
+#include <sys/resource.h>
+#include <chrono>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct BenchmarkConfig {
+    int documents = 10'000;
+    int vocabulary = 1'000;
+    int max_word_length = 10;
+    int document_words = 70;
+    int queries = 100;
+    int query_words = 70;
+    double minus_prob = 0.1;
+    double zipf_exponent = 1.0;
+    double actual_fraction = 0.5;
+    double duplicate_fraction = 0.1;
+    double remove_fraction = 0.1;
+    int match_batch = 50;
+    size_t postings_budget = 20'000;
+    // Число эмулируемых узлов NUMA для process_queries_numa, 0 — узлы машины
+    size_t numa_nodes = 0;
+    int iterations = 3;
+    unsigned seed = mt19937::default_seed;
+};
+
+BenchmarkConfig ParseConfig(const CommandLineOptions& options) {
+    BenchmarkConfig config;
+    config.documents = options.Get("documents"s, config.documents);
+    config.vocabulary = options.Get("vocabulary"s, config.vocabulary);
+    config.max_word_length = options.Get("max-word-length"s, config.max_word_length);
+    config.document_words = options.Get("document-words"s, config.document_words);
+    config.queries = options.Get("queries"s, config.queries);
+    config.query_words = options.Get("query-words"s, config.query_words);
+    config.minus_prob = options.Get("minus-prob"s, config.minus_prob);
+    config.zipf_exponent = options.Get("zipf"s, config.zipf_exponent);
+    config.actual_fraction = options.Get("actual-fraction"s, config.actual_fraction);
+    config.duplicate_fraction = options.Get("duplicate-fraction"s, config.duplicate_fraction);
+    config.remove_fraction = options.Get("remove-fraction"s, config.remove_fraction);
+    config.match_batch = options.Get("match-batch"s, config.match_batch);
+    config.postings_budget = options.Get("postings-budget"s, config.postings_budget);
+    config.numa_nodes = options.Get("numa-nodes"s, config.numa_nodes);
+    config.iterations = options.Get("iterations"s, config.iterations);
+    config.seed = options.Get("seed"s, config.seed);
+    return config;
+}
+
+struct Corpus {
+    vector<string> dictionary;
+    vector<string> documents;
+    vector<DocumentStatus> statuses;
+    vector<vector<int>> ratings;
+    vector<string> queries;
+};
+
+Corpus GenerateCorpus(const BenchmarkConfig& config) {
+    mt19937 generator(config.seed);
+    Corpus corpus;
+    corpus.dictionary = GenerateDictionary(generator, config.vocabulary, config.max_word_length);
+    ZipfDistribution word_distribution(corpus.dictionary.size(), config.zipf_exponent);
+    corpus.documents = GenerateQueries(generator, corpus.dictionary, word_distribution, config.documents, config.document_words);
+    for (int i = 0; i < config.documents; ++i) {
+        const bool is_actual = uniform_real_distribution<>(0, 1)(generator) < config.actual_fraction;
+        corpus.statuses.push_back(is_actual ? DocumentStatus::ACTUAL : DocumentStatus::IRRELEVANT);
+        corpus.ratings.push_back({uniform_int_distribution(-10, 10)(generator), uniform_int_distribution(-10, 10)(generator)});
+    }
+    corpus.queries = GenerateQueries(generator, corpus.dictionary, word_distribution, config.queries, config.query_words, config.minus_prob);
+    return corpus;
+}
+
+SearchServer BuildServer(const Corpus& corpus, RankingFunction ranking_function = RankingFunction::TF_IDF) {
+    SearchServer search_server(corpus.dictionary[0], ranking_function);
+    for (size_t i = 0; i < corpus.documents.size(); ++i) {
+        search_server.AddDocument(i, corpus.documents[i], corpus.statuses[i], corpus.ratings[i]);
+    }
+    return search_server;
+}
+
+// Пик памяти всего процесса: ru_maxrss не уменьшается, поэтому у каждого
+// следующего замера он не меньше, чем у предыдущих
+long GetProcessPeakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+class Benchmark {
+public:
+    using Clock = chrono::steady_clock;
+
+    explicit Benchmark(string name)
+        : name_(move(name)) {
+    }
+
+    template <typename Operation>
+    void Measure(uint64_t operations, Operation operation) {
+        const auto start_time = Clock::now();
+        operation();
+        const auto duration = Clock::now() - start_time;
+        latency_.Add(chrono::duration_cast<chrono::nanoseconds>(duration).count());
+        operations_ += operations;
+        total_ += duration;
+    }
+
+    void Print(ostream& out) const {
+        const double seconds = chrono::duration<double>(total_).count();
+        out << "{\"benchmark\": \""s << name_ << "\", \"samples\": "s << latency_.GetCount()
+            << ", \"operations\": "s << operations_
+            << ", \"total_ms\": "s << seconds * 1000
+            << ", \"throughput_ops_per_s\": "s << (seconds > 0 ? operations_ / seconds : 0.0)
+            << ", \"p50_ns\": "s << latency_.GetValueAtPercentile(50)
+            << ", \"p90_ns\": "s << latency_.GetValueAtPercentile(90)
+            << ", \"p99_ns\": "s << latency_.GetValueAtPercentile(99)
+            << ", \"p999_ns\": "s << latency_.GetValueAtPercentile(99.9)
+            << ", \"max_ns\": "s << latency_.GetMax()
+            << ", \"process_peak_rss_kb\": "s << GetProcessPeakRssKb() << '}' << endl;
+    }
+
+private:
+    const string name_;
+    HdrHistogram latency_;
+    uint64_t operations_ = 0;
+    Clock::duration total_{};
+};
+
+void BenchmarkAddDocument(const BenchmarkConfig& config, const Corpus& corpus) {
+    Benchmark benchmark("add_document"s);
+    for (int iteration = 0; iteration < config.iterations; ++iteration) {
+        SearchServer search_server(corpus.dictionary[0]);
+        for (size_t i = 0; i < corpus.documents.size(); ++i) {
+            benchmark.Measure(1, [&] {
+                search_server.AddDocument(i, corpus.documents[i], corpus.statuses[i], corpus.ratings[i]);
+            });
+        }
+    }
+    benchmark.Print(cout);
+}
+
+template <typename Search>
+void BenchmarkSearch(const string& name, const BenchmarkConfig& config, const Corpus& corpus, Search search) {
+    Benchmark benchmark(name);
+    for (int iteration = 0; iteration < config.iterations; ++iteration) {
+        for (const string& query : corpus.queries) {
+            benchmark.Measure(1, [&] {
+                search(query);
+            });
+        }
+    }
+    benchmark.Print(cout);
+}
+
+void BenchmarkFindTopDocuments(const BenchmarkConfig& config, const Corpus& corpus, const SearchServer& search_server) {
+    const auto predicate = [](int document_id, DocumentStatus, int rating) {
+        return document_id % 2 == 0 && rating > 0;
+    };
+    BenchmarkSearch("find_top_documents_seq"s, config, corpus, [&](const string& query) {
+        return search_server.FindTopDocuments(execution::seq, query);
+    });
+    BenchmarkSearch("find_top_documents_par"s, config, corpus, [&](const string& query) {
+        return search_server.FindTopDocuments(execution::par, query);
+    });
+    BenchmarkSearch("find_top_documents_predicate_seq"s, config, corpus, [&](const string& query) {
+        return search_server.FindTopDocuments(execution::seq, query, predicate);
+    });
+    BenchmarkSearch("find_top_documents_predicate_par"s, config, corpus, [&](const string& query) {
+        return search_server.FindTopDocuments(execution::par, query, predicate);
+    });
+    BenchmarkSearch("find_top_documents_by_impact"s, config, corpus, [&](const string& query) {
+        return search_server.FindTopDocumentsByImpact(query, {});
+    });
+    BenchmarkSearch("find_top_documents_by_impact_budget"s, config, corpus, [&](const string& query) {
+        return search_server.FindTopDocumentsByImpact(query, {MAX_RESULT_DOCUMENT_COUNT, config.postings_budget});
+    });
+    BenchmarkSearch("stream_top_documents_first_2"s, config, corpus, [&](const string& query) {
+        auto stream = search_server.StreamTopDocuments(query);
+        stream.Next();
+        return stream.Next();
+    });
+}
+
+// Те же запросы с BM25: сравнение с find_top_documents_* показывает цену нормализации по длине
+void BenchmarkBm25(const BenchmarkConfig& config, const Corpus& corpus) {
+    const SearchServer search_server = BuildServer(corpus, RankingFunction::BM25);
+    BenchmarkSearch("find_top_documents_bm25_seq"s, config, corpus, [&](const string& query) {
+        return search_server.FindTopDocuments(execution::seq, query);
+    });
+    BenchmarkSearch("find_top_documents_bm25_par"s, config, corpus, [&](const string& query) {
+        return search_server.FindTopDocuments(execution::par, query);
+    });
+    BenchmarkSearch("find_top_documents_by_impact_bm25"s, config, corpus, [&](const string& query) {
+        return search_server.FindTopDocumentsByImpact(query, {});
+    });
+    BenchmarkSearch("stream_top_documents_first_2_bm25"s, config, corpus, [&](const string& query) {
+        auto stream = search_server.StreamTopDocuments(query);
+        stream.Next();
+        return stream.Next();
+    });
+}
+
+void BenchmarkMatchDocument(const BenchmarkConfig& config, const Corpus& corpus, const SearchServer& search_server) {
+    mt19937 generator(config.seed);
+    uniform_int_distribution<int> document_id(0, corpus.documents.size() - 1);
+    BenchmarkSearch("match_document_seq"s, config, corpus, [&](const string& query) {
+        return search_server.MatchDocument(execution::seq, query, document_id(generator));
+    });
+    BenchmarkSearch("match_document_par"s, config, corpus, [&](const string& query) {
+        return search_server.MatchDocument(execution::par, query, document_id(generator));
+    });
+    vector<int> batch_ids(config.match_batch);
+    BenchmarkSearch("match_documents_batch"s, config, corpus, [&](const string& query) {
+        generate(batch_ids.begin(), batch_ids.end(), [&] { return document_id(generator); });
+        return search_server.MatchDocuments(query, batch_ids);
+    });
+}
+
+template <typename ExecutionPolicy>
+void BenchmarkRemoveDocument(const string& name, const BenchmarkConfig& config, const Corpus& corpus, ExecutionPolicy policy) {
+    Benchmark benchmark(name);
+    const int remove_count = static_cast<int>(corpus.documents.size() * config.remove_fraction);
+    for (int iteration = 0; iteration < config.iterations; ++iteration) {
+        SearchServer search_server = BuildServer(corpus);
+        mt19937 generator(config.seed + iteration);
+        vector<int> ids(search_server.begin(), search_server.end());
+        shuffle(ids.begin(), ids.end(), generator);
+        for (int i = 0; i < remove_count; ++i) {
+            benchmark.Measure(1, [&] {
+                search_server.RemoveDocument(policy, ids[i]);
+            });
+        }
+    }
+    benchmark.Print(cout);
+}
+
+void BenchmarkRemoveDuplicates(const BenchmarkConfig& config, const Corpus& corpus) {
+    Benchmark benchmark("remove_duplicates"s);
+    const int duplicate_count = static_cast<int>(corpus.documents.size() * config.duplicate_fraction);
+    for (int iteration = 0; iteration < config.iterations; ++iteration) {
+        SearchServer search_server = BuildServer(corpus);
+        mt19937 generator(config.seed + iteration);
+        uniform_int_distribution<int> source_id(0, corpus.documents.size() - 1);
+        for (int i = 0; i < duplicate_count; ++i) {
+            const int source = source_id(generator);
+            search_server.AddDocument(corpus.documents.size() + i, corpus.documents[source], corpus.statuses[source], corpus.ratings[source]);
+        }
+        // RemoveDuplicates сообщает о каждом дубликате в cout, а он занят результатами
+        ostringstream discarded;
+        streambuf* cout_buffer = cout.rdbuf(discarded.rdbuf());
+        benchmark.Measure(search_server.GetDocumentCount(), [&] {
+            RemoveDuplicates(search_server);
+        });
+        cout.rdbuf(cout_buffer);
+    }
+    benchmark.Print(cout);
+}
+
+void BenchmarkProcessQueries(const BenchmarkConfig& config, const Corpus& corpus, const SearchServer& search_server) {
+    Benchmark benchmark("process_queries"s);
+    for (int iteration = 0; iteration < config.iterations; ++iteration) {
+        benchmark.Measure(corpus.queries.size(), [&] {
+            return ProcessQueries(search_server, corpus.queries);
+        });
+    }
+    benchmark.Print(cout);
+}
+
+void BenchmarkProcessQueriesNuma(const BenchmarkConfig& config, const Corpus& corpus, const SearchServer& search_server) {
+    NumaOptions options;
+    options.emulated_node_count = config.numa_nodes;
+    const NumaSearchServer numa_server(search_server, options);
+    Benchmark benchmark("process_queries_numa"s);
+    for (int iteration = 0; iteration < config.iterations; ++iteration) {
+        benchmark.Measure(corpus.queries.size(), [&] {
+            return ProcessQueries(numa_server, corpus.queries);
+        });
+    }
+    benchmark.Print(cout);
+}
+
+void PrintConfig(ostream& out, const BenchmarkConfig& config) {
+    out << "{\"config\": {\"documents\": "s << config.documents
+        << ", \"vocabulary\": "s << config.vocabulary
+        << ", \"max_word_length\": "s << config.max_word_length
+        << ", \"document_words\": "s << config.document_words
+        << ", \"queries\": "s << config.queries
+        << ", \"query_words\": "s << config.query_words
+        << ", \"minus_prob\": "s << config.minus_prob
+        << ", \"zipf\": "s << config.zipf_exponent
+        << ", \"actual_fraction\": "s << config.actual_fraction
+        << ", \"duplicate_fraction\": "s << config.duplicate_fraction
+        << ", \"remove_fraction\": "s << config.remove_fraction
+        << ", \"match_batch\": "s << config.match_batch
+        << ", \"postings_budget\": "s << config.postings_budget
+        << ", \"numa_nodes\": "s << config.numa_nodes
+        << ", \"iterations\": "s << config.iterations
+        << ", \"seed\": "s << config.seed << "}}"s << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        const BenchmarkConfig config = ParseConfig(CommandLineOptions(argc, argv, 1));
+        PrintConfig(cout, config);
+        const Corpus corpus = GenerateCorpus(config);
+        BenchmarkAddDocument(config, corpus);
+        const SearchServer search_server = BuildServer(corpus);
+        BenchmarkFindTopDocuments(config, corpus, search_server);
+        BenchmarkBm25(config, corpus);
+        BenchmarkMatchDocument(config, corpus, search_server);
+        BenchmarkProcessQueries(config, corpus, search_server);
+        BenchmarkProcessQueriesNuma(config, corpus, search_server);
+        BenchmarkRemoveDocument("remove_document_seq"s, config, corpus, execution::seq);
+        BenchmarkRemoveDocument("remove_document_par"s, config, corpus, execution::par);
+        BenchmarkRemoveDuplicates(config, corpus);
+        PrintSnapshot(cout, Instrumentation::GetSnapshot());
+        cout << endl;
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,138 @@
+#include "binary_io.h"
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace {
+
+constexpr std::array<uint32_t, 256> MakeCrc32Table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC32_TABLE = MakeCrc32Table();
+
+}
+
+BinaryWriter& BinaryWriter::WriteUint8(uint8_t value) {
+    buffer_.push_back(static_cast<char>(value));
+    return *this;
+}
+
+BinaryWriter& BinaryWriter::WriteUint32(uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        buffer_.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+    return *this;
+}
+
+BinaryWriter& BinaryWriter::WriteUint64(uint64_t value) {
+    WriteUint32(static_cast<uint32_t>(value));
+    return WriteUint32(static_cast<uint32_t>(value >> 32));
+}
+
+BinaryWriter& BinaryWriter::WriteInt32(int32_t value) {
+    return WriteUint32(static_cast<uint32_t>(value));
+}
+
+BinaryWriter& BinaryWriter::WriteDouble(double value) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return WriteUint64(bits);
+}
+
+BinaryWriter& BinaryWriter::WriteString(std::string_view value) {
+    WriteUint32(static_cast<uint32_t>(value.size()));
+    buffer_.append(value);
+    return *this;
+}
+
+const std::string& BinaryWriter::GetData() const {
+    return buffer_;
+}
+
+void BinaryWriter::Clear() {
+    buffer_.clear();
+}
+
+BinaryReader::BinaryReader(std::string_view data)
+    : data_(data)
+{
+}
+
+uint8_t BinaryReader::ReadUint8() {
+    return static_cast<uint8_t>(Take(1)[0]);
+}
+
+uint32_t BinaryReader::ReadUint32() {
+    return DecodeUint32(Take(4));
+}
+
+uint64_t BinaryReader::ReadUint64() {
+    const uint64_t low = ReadUint32();
+    const uint64_t high = ReadUint32();
+    return low | (high << 32);
+}
+
+int32_t BinaryReader::ReadInt32() {
+    return static_cast<int32_t>(ReadUint32());
+}
+
+double BinaryReader::ReadDouble() {
+    const uint64_t bits = ReadUint64();
+    double value = 0;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::string_view BinaryReader::ReadString() {
+    const uint32_t size = ReadUint32();
+    return Take(size);
+}
+
+uint32_t BinaryReader::ReadCount(size_t min_element_size) {
+    const uint32_t count = ReadUint32();
+    if (count > data_.size() / min_element_size) {
+        throw std::runtime_error("Данные обрезаны"s);
+    }
+    return count;
+}
+
+bool BinaryReader::IsEnd() const {
+    return data_.empty();
+}
+
+std::string_view BinaryReader::Take(size_t size) {
+    if (data_.size() < size) {
+        throw std::runtime_error("Данные обрезаны"s);
+    }
+    const std::string_view result = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return result;
+}
+
+uint32_t DecodeUint32(std::string_view data) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+uint32_t ComputeCrc32(std::string_view data, uint32_t previous_crc) {
+    uint32_t crc = ~previous_crc;
+    for (const char c : data) {
+        crc = CRC32_TABLE[(crc ^ static_cast<unsigned char>(c)) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
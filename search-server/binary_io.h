@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Общее двоичное кодирование протокола, журнала и снимков: числа little-endian, строки — длина (uint32) и байты
+class BinaryWriter {
+public:
+    BinaryWriter& WriteUint8(uint8_t value);
+    BinaryWriter& WriteUint32(uint32_t value);
+    BinaryWriter& WriteUint64(uint64_t value);
+    BinaryWriter& WriteInt32(int32_t value);
+    BinaryWriter& WriteDouble(double value);
+    BinaryWriter& WriteString(std::string_view value);
+
+    const std::string& GetData() const;
+    void Clear();
+
+protected:
+    std::string buffer_;
+};
+
+// Читает данные, записанные BinaryWriter; при нехватке данных бросает std::runtime_error
+class BinaryReader {
+public:
+    explicit BinaryReader(std::string_view data);
+
+    uint8_t ReadUint8();
+    uint32_t ReadUint32();
+    uint64_t ReadUint64();
+    int32_t ReadInt32();
+    double ReadDouble();
+    // Результат ссылается на читаемые данные
+    std::string_view ReadString();
+    // Читает число элементов; бросает std::runtime_error, если оставшихся данных
+    // не хватит даже на столько элементов минимального размера
+    uint32_t ReadCount(size_t min_element_size);
+
+    bool IsEnd() const;
+
+private:
+    std::string_view data_;
+
+    std::string_view Take(size_t size);
+};
+
+uint32_t DecodeUint32(std::string_view data);
+
+// CRC-32 (IEEE 802.3); для подсчёта по частям передаётся результат предыдущей части
+uint32_t ComputeCrc32(std::string_view data, uint32_t previous_crc = 0);
@@ -0,0 +1,22 @@
+#include "command_line.h"
+
+#include <string_view>
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+CommandLineOptions::CommandLineOptions(int argc, char* argv[], int first) {
+    for (int i = first; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const size_t eq = arg.find('=');
+        if (arg.substr(0, 2) != "--"sv || eq == std::string_view::npos) {
+            throw std::invalid_argument("Ожидается аргумент вида --name=value: "s + std::string(arg));
+        }
+        values_[std::string(arg.substr(2, eq - 2))] = std::string(arg.substr(eq + 1));
+    }
+}
+
+std::string CommandLineOptions::GetString(const std::string& name, const std::string& default_value) const {
+    const auto it = values_.find(name);
+    return it == values_.end() ? default_value : it->second;
+}
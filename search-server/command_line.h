@@ -0,0 +1,36 @@
+#pragma once
+
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Аргументы командной строки вида --name=value
+class CommandLineOptions {
+public:
+    CommandLineOptions(int argc, char* argv[], int first);
+
+    template <typename T>
+    T Get(const std::string& name, T default_value) const;
+
+    std::string GetString(const std::string& name, const std::string& default_value) const;
+
+private:
+    std::map<std::string, std::string> values_;
+};
+
+template <typename T>
+T CommandLineOptions::Get(const std::string& name, T default_value) const {
+    using namespace std::string_literals;
+    const auto it = values_.find(name);
+    if (it == values_.end()) {
+        return default_value;
+    }
+    std::istringstream in(it->second);
+    T value;
+    in >> value;
+    if (!in) {
+        throw std::invalid_argument("Некорректное значение аргумента: "s + name);
+    }
+    return value;
+}
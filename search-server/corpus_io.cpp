@@ -0,0 +1,55 @@
+#include "corpus_io.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace {
+
+std::ifstream OpenFile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::invalid_argument("Не удалось открыть файл: "s + path);
+    }
+    return in;
+}
+
+}
+
+void LoadCorpus(SearchServer& search_server, const std::string& path, int shard_index, int shard_count) {
+    std::ifstream in = OpenFile(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string id, status, ratings_text, text;
+        if (!std::getline(fields, id, '\t') || !std::getline(fields, status, '\t') || !std::getline(fields, ratings_text, '\t')) {
+            throw std::invalid_argument("Некорректная строка корпуса: "s + line);
+        }
+        const int document_id = std::stoi(id);
+        if (document_id % shard_count != shard_index) {
+            continue;
+        }
+        const int status_value = std::stoi(status);
+        if (status_value < 0 || status_value >= static_cast<int>(DOCUMENT_STATUSES_COUNT)) {
+            throw std::invalid_argument("Некорректный статус документа: "s + status);
+        }
+        std::getline(fields, text);
+        std::vector<int> ratings;
+        std::istringstream ratings_stream(ratings_text);
+        for (std::string rating; std::getline(ratings_stream, rating, ',');) {
+            ratings.push_back(std::stoi(rating));
+        }
+        search_server.AddDocument(document_id, text, static_cast<DocumentStatus>(status_value), ratings);
+    }
+}
+
+std::vector<std::string> LoadQueries(const std::string& path) {
+    std::ifstream in = OpenFile(path);
+    std::vector<std::string> queries;
+    for (std::string line; std::getline(in, line);) {
+        queries.push_back(line);
+    }
+    return queries;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+// Строка корпуса: id, статус (число), рейтинги через запятую и текст через табуляцию.
+// Журнал запросов — по запросу в строке
+
+// Загружает документы корпуса, для которых id % shard_count == shard_index
+void LoadCorpus(SearchServer& search_server, const std::string& path, int shard_index = 0, int shard_count = 1);
+
+std::vector<std::string> LoadQueries(const std::string& path);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+
+// Статистика корпуса для IDF и BM25. Статистики частей разделённого корпуса
+// складываются, чтобы каждая часть считала релевантность как единый корпус
+struct CorpusStatistics {
+    int document_count = 0;
+    int64_t total_document_length = 0;
+    std::map<std::string, int, std::less<>> document_freqs;
+
+    void Merge(const CorpusStatistics& other) {
+        document_count += other.document_count;
+        total_document_length += other.total_document_length;
+        for (const auto& [word, document_freq] : other.document_freqs) {
+            document_freqs[word] += document_freq;
+        }
+    }
+};
@@ -23,4 +23,6 @@ enum class DocumentStatus {
     REMOVED,
 };
 
+constexpr unsigned DOCUMENT_STATUSES_COUNT = 4;
+
 std::ostream& operator<<(std::ostream& out, const Document& doc);
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <limits>
+
+#include "document.h"
+
+// Набор статусов и диапазон рейтинга: статусы проверяются по индексам статусов,
+// рейтинг — только у найденных документов
+struct DocumentFilter {
+    DocumentFilter() = default;
+
+    explicit DocumentFilter(DocumentStatus status)
+        : status_mask(GetStatusBit(status)) {
+    }
+
+    DocumentFilter& AddStatus(DocumentStatus status) {
+        status_mask |= GetStatusBit(status);
+        return *this;
+    }
+
+    DocumentFilter& SetRatingRange(int min, int max) {
+        min_rating = min;
+        max_rating = max;
+        return *this;
+    }
+
+    bool HasStatus(DocumentStatus status) const {
+        return (status_mask & GetStatusBit(status)) != 0;
+    }
+
+    bool HasRatingRange() const {
+        return min_rating != std::numeric_limits<int>::min() || max_rating != std::numeric_limits<int>::max();
+    }
+
+    // Позволяет использовать фильтр везде, где ожидается предикат
+    bool operator()(int /*document_id*/, DocumentStatus status, int rating) const {
+        return HasStatus(status) && rating >= min_rating && rating <= max_rating;
+    }
+
+    static unsigned GetStatusBit(DocumentStatus status) {
+        return 1u << static_cast<unsigned>(status);
+    }
+
+    unsigned status_mask = (1u << DOCUMENT_STATUSES_COUNT) - 1;
+    int min_rating = std::numeric_limits<int>::min();
+    int max_rating = std::numeric_limits<int>::max();
+};
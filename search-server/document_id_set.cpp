@@ -0,0 +1,88 @@
+#include "document_id_set.h"
+
+#include <algorithm>
+
+namespace {
+
+// Битовая карта выбирается, пока на каждый id приходится не больше
+// нескольких слов карты: тогда она не больше хеш-множества. Пороги
+// перехода различаются, чтобы множество не переключалось туда и обратно.
+constexpr size_t DENSE_WORDS_PER_ID = 2;
+constexpr size_t SPARSE_WORDS_PER_ID = 4;
+constexpr size_t MIN_DENSE_WORDS = 64;
+
+size_t GetWordCount(int max_document_id) {
+    return static_cast<size_t>(max_document_id) / 64 + 1;
+}
+
+}
+
+void DocumentIdSet::Insert(int document_id) {
+    if (Contains(document_id)) {
+        return;
+    }
+    ++count_;
+    if (is_dense_) {
+        const size_t word = static_cast<size_t>(document_id) / 64;
+        if (word >= words_.size()) {
+            if (word + 1 > count_ * SPARSE_WORDS_PER_ID + MIN_DENSE_WORDS) {
+                MakeSparse();
+                sparse_ids_.insert(document_id);
+                max_sparse_id_ = std::max(max_sparse_id_, document_id);
+                return;
+            }
+            words_.resize(std::max(word + 1, std::min(words_.size() * 2, count_ * SPARSE_WORDS_PER_ID + MIN_DENSE_WORDS)), 0);
+        }
+        words_[word] |= uint64_t(1) << (document_id % 64);
+        return;
+    }
+    sparse_ids_.insert(document_id);
+    max_sparse_id_ = std::max(max_sparse_id_, document_id);
+    if (GetWordCount(max_sparse_id_) <= count_ * DENSE_WORDS_PER_ID + MIN_DENSE_WORDS) {
+        MakeDense();
+    }
+}
+
+void DocumentIdSet::Erase(int document_id) {
+    if (!Contains(document_id)) {
+        return;
+    }
+    --count_;
+    if (!is_dense_) {
+        sparse_ids_.erase(document_id);
+        return;
+    }
+    words_[static_cast<size_t>(document_id) / 64] &= ~(uint64_t(1) << (document_id % 64));
+    if (words_.size() > count_ * SPARSE_WORDS_PER_ID + MIN_DENSE_WORDS) {
+        MakeSparse();
+    }
+}
+
+size_t DocumentIdSet::GetCount() const {
+    return count_;
+}
+
+void DocumentIdSet::MakeDense() {
+    words_.assign(GetWordCount(max_sparse_id_), 0);
+    for (const int document_id : sparse_ids_) {
+        words_[static_cast<size_t>(document_id) / 64] |= uint64_t(1) << (document_id % 64);
+    }
+    sparse_ids_ = {};
+    max_sparse_id_ = -1;
+    is_dense_ = true;
+}
+
+void DocumentIdSet::MakeSparse() {
+    sparse_ids_.reserve(count_);
+    for (size_t word = 0; word < words_.size(); ++word) {
+        for (size_t bit = 0; bit < 64; ++bit) {
+            if ((words_[word] >> bit) & 1) {
+                const int document_id = static_cast<int>(word * 64 + bit);
+                sparse_ids_.insert(document_id);
+                max_sparse_id_ = std::max(max_sparse_id_, document_id);
+            }
+        }
+    }
+    words_ = {};
+    is_dense_ = false;
+}
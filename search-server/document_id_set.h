@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+// Множество неотрицательных id документов. Пока id плотные, оно хранится
+// битовой картой, иначе — хеш-множеством, чтобы память зависела от числа
+// документов, а не от наибольшего id.
+class DocumentIdSet {
+public:
+    void Insert(int document_id);
+    void Erase(int document_id);
+
+    bool Contains(int document_id) const {
+        if (!is_dense_) {
+            return sparse_ids_.count(document_id) > 0;
+        }
+        const size_t word = static_cast<size_t>(document_id) / 64;
+        return word < words_.size() && ((words_[word] >> (document_id % 64)) & 1);
+    }
+
+    bool operator()(int document_id) const {
+        return Contains(document_id);
+    }
+
+    size_t GetCount() const;
+
+private:
+    std::vector<uint64_t> words_;
+    std::unordered_set<int> sparse_ids_;
+    size_t count_ = 0;
+    bool is_dense_ = true;
+    // Наибольший id, добавленный в хеш-множество; при удалении не уменьшается
+    int max_sparse_id_ = -1;
+
+    void MakeDense();
+    void MakeSparse();
+};
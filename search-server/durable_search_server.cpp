@@ -0,0 +1,268 @@
+#include "durable_search_server.h"
+
+#include <algorithm>
+#include <execution>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "binary_io.h"
+#include "file_io.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+const std::string SNAPSHOT_PREFIX = "snapshot-"s;
+const std::string SNAPSHOT_SUFFIX = ".bin"s;
+constexpr uint32_t SNAPSHOT_MAGIC = 0x504E5353;
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+
+std::string MakeSnapshotPath(const std::string& directory, uint64_t lsn) {
+    std::ostringstream path;
+    path << directory << '/' << SNAPSHOT_PREFIX << std::setw(20) << std::setfill('0') << lsn << SNAPSHOT_SUFFIX;
+    return path.str();
+}
+
+// Номер последней записи журнала в снимке -> путь
+std::map<uint64_t, std::string> ListSnapshots(const std::string& directory) {
+    std::map<uint64_t, std::string> snapshots;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() <= SNAPSHOT_PREFIX.size() + SNAPSHOT_SUFFIX.size()
+                || name.compare(0, SNAPSHOT_PREFIX.size(), SNAPSHOT_PREFIX) != 0
+                || name.compare(name.size() - SNAPSHOT_SUFFIX.size(), SNAPSHOT_SUFFIX.size(), SNAPSHOT_SUFFIX) != 0) {
+            continue;
+        }
+        const std::string number = name.substr(SNAPSHOT_PREFIX.size(), name.size() - SNAPSHOT_PREFIX.size() - SNAPSHOT_SUFFIX.size());
+        if (number.find_first_not_of("0123456789"s) == std::string::npos) {
+            snapshots.emplace(std::stoull(number), entry.path().string());
+        }
+    }
+    return snapshots;
+}
+
+}
+
+DurableSearchServer::DurableSearchServer(SearchServer search_server, std::string directory, WriteAheadLogOptions options)
+    : directory_(std::move(directory))
+    , search_server_(std::move(search_server))
+    , log_(directory_, options)
+{
+    if (search_server_.GetDocumentCount() != 0) {
+        throw std::invalid_argument("Восстанавливаемый сервер должен быть пустым"s);
+    }
+    LoadSnapshot();
+    if (log_.GetLastLsn() < snapshot_lsn_) {
+        throw std::runtime_error("Журнал не содержит записей, вошедших в снимок"s);
+    }
+    ReplayLog();
+}
+
+void DurableSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    // Разбор текста не зависит от индекса и отклоняет недопустимые слова до записи в журнал
+    TokenizedDocument tokenized_document = search_server_.TokenizeDocument(document);
+    LogRecord record;
+    record.type = LogRecordType::ADD_DOCUMENT;
+    record.document_id = document_id;
+    record.status = status;
+    record.ratings = ratings;
+    record.text = document;
+    const uint64_t lsn = AppendRecord(std::move(record));
+    try {
+        // Ожидание диска вне блокировок: за это время другие потоки успевают
+        // добавить свои записи в тот же пакет
+        log_.WaitDurable(lsn);
+        std::unique_lock lock(index_mutex_);
+        search_server_.AddTokenizedDocument(document_id, std::move(tokenized_document), status, ratings);
+    } catch (...) {
+        ReleaseDocumentId(document_id);
+        throw;
+    }
+    ReleaseDocumentId(document_id);
+}
+
+void DurableSearchServer::RemoveDocument(int document_id) {
+    LogRecord record;
+    record.type = LogRecordType::REMOVE_DOCUMENT;
+    record.document_id = document_id;
+    const uint64_t lsn = AppendRecord(std::move(record));
+    try {
+        log_.WaitDurable(lsn);
+        std::unique_lock lock(index_mutex_);
+        search_server_.RemoveDocument(document_id);
+    } catch (...) {
+        ReleaseDocumentId(document_id);
+        throw;
+    }
+    ReleaseDocumentId(document_id);
+}
+
+uint64_t DurableSearchServer::AppendRecord(LogRecord record) {
+    const int document_id = record.document_id;
+    std::unique_lock write_lock(write_mutex_);
+    pending_condition_.wait(write_lock, [this]() {
+        return !is_checkpoint_waiting_;
+    });
+    // Изменяемый документ считается ещё не добавленным или уже удалённым,
+    // смотря по тому, какая операция проверяется
+    const bool is_pending = pending_document_ids_.count(document_id) != 0;
+    if (record.type == LogRecordType::ADD_DOCUMENT) {
+        if (is_pending) {
+            throw std::invalid_argument("id добавляемого документа уже существует"s);
+        }
+        std::shared_lock lock(index_mutex_);
+        search_server_.CheckNewDocumentId(document_id);
+    } else {
+        if (is_pending) {
+            throw std::out_of_range("document_id не существует"s);
+        }
+        std::shared_lock lock(index_mutex_);
+        // Бросает то же std::out_of_range, что и SearchServer::RemoveDocument
+        search_server_.GetDocumentStatus(document_id);
+    }
+    const uint64_t lsn = log_.Append(std::move(record));
+    pending_document_ids_.insert(document_id);
+    return lsn;
+}
+
+void DurableSearchServer::ReleaseDocumentId(int document_id) {
+    {
+        std::lock_guard guard(write_mutex_);
+        pending_document_ids_.erase(document_id);
+    }
+    pending_condition_.notify_all();
+}
+
+void DurableSearchServer::Checkpoint() {
+    std::lock_guard checkpoint_guard(checkpoint_mutex_);
+    uint64_t lsn = 0;
+    BinaryWriter snapshot;
+    {
+        // Снимок должен содержать ровно записи журнала до lsn: новые изменения
+        // ждут, пока применятся уже записанные
+        std::unique_lock write_lock(write_mutex_);
+        is_checkpoint_waiting_ = true;
+        pending_condition_.wait(write_lock, [this]() {
+            return pending_document_ids_.empty();
+        });
+        is_checkpoint_waiting_ = false;
+        pending_condition_.notify_all();
+        std::shared_lock lock(index_mutex_);
+        lsn = log_.GetLastLsn();
+        if (lsn == snapshot_lsn_) {
+            return;
+        }
+        // Копия в памяти снимается быстро, а запись на диск не задерживает изменения
+        snapshot = SerializeSnapshot(lsn);
+    }
+    // Снимок не должен опережать журнал на диске: иначе после сбоя номера
+    // новых записей совпали бы с номерами записей, уже вошедших в снимок
+    log_.WaitDurable(lsn);
+    const std::string path = MakeSnapshotPath(directory_, lsn);
+    const std::string temporary_path = path + ".tmp"s;
+    std::filesystem::remove(temporary_path);
+    {
+        AppendFile file(temporary_path);
+        file.Append(snapshot.GetData());
+        file.Sync();
+    }
+    snapshot.Clear();
+    std::filesystem::rename(temporary_path, path);
+    SyncDirectory(directory_);
+
+    // Предыдущий снимок и журнал после него остаются: LoadSnapshot переходит
+    // к ним, если новый снимок окажется повреждён
+    const uint64_t previous_lsn = snapshot_lsn_;
+    for (const auto& [snapshot_lsn, snapshot_path] : ListSnapshots(directory_)) {
+        if (snapshot_lsn != lsn && snapshot_lsn != previous_lsn) {
+            std::filesystem::remove(snapshot_path);
+        }
+    }
+    log_.Truncate(previous_lsn + 1);
+    snapshot_lsn_ = lsn;
+}
+
+const WriteAheadLog& DurableSearchServer::GetLog() const {
+    return log_;
+}
+
+uint64_t DurableSearchServer::GetSnapshotLsn() const {
+    std::lock_guard guard(checkpoint_mutex_);
+    return snapshot_lsn_;
+}
+
+BinaryWriter DurableSearchServer::SerializeSnapshot(uint64_t lsn) const {
+    BinaryWriter writer;
+    writer.WriteUint32(SNAPSHOT_MAGIC).WriteUint32(SNAPSHOT_VERSION).WriteUint64(lsn);
+    writer.WriteUint32(static_cast<uint32_t>(search_server_.GetDocumentCount()));
+    for (const int document_id : search_server_) {
+        const auto& word_frequencies = search_server_.GetWordFrequencies(document_id);
+        writer.WriteInt32(document_id)
+              .WriteUint8(static_cast<uint8_t>(search_server_.GetDocumentStatus(document_id)))
+              .WriteInt32(search_server_.GetDocumentRating(document_id))
+              .WriteInt32(search_server_.GetDocumentLength(document_id))
+              .WriteUint32(static_cast<uint32_t>(word_frequencies.size()));
+        for (const auto& [word, term_freq] : word_frequencies) {
+            writer.WriteString(word).WriteDouble(term_freq);
+        }
+    }
+    writer.WriteUint32(ComputeCrc32(writer.GetData()));
+    return writer;
+}
+
+void DurableSearchServer::LoadSnapshot() {
+    const std::map<uint64_t, std::string> snapshots = ListSnapshots(directory_);
+    // Если последний снимок повреждён, используется предыдущий
+    for (auto it = snapshots.rbegin(); it != snapshots.rend(); ++it) {
+        const std::string data = ReadFile(it->second);
+        if (data.size() < 4 || ComputeCrc32(std::string_view(data).substr(0, data.size() - 4)) != DecodeUint32(std::string_view(data).substr(data.size() - 4))) {
+            continue;
+        }
+        BinaryReader reader(std::string_view(data).substr(0, data.size() - 4));
+        if (reader.ReadUint32() != SNAPSHOT_MAGIC || reader.ReadUint32() != SNAPSHOT_VERSION) {
+            throw std::runtime_error("Неизвестный формат снимка: "s + it->second);
+        }
+        snapshot_lsn_ = reader.ReadUint64();
+        const uint32_t document_count = reader.ReadUint32();
+        for (uint32_t i = 0; i < document_count; ++i) {
+            const int document_id = reader.ReadInt32();
+            const uint8_t status = reader.ReadUint8();
+            if (status >= DOCUMENT_STATUSES_COUNT) {
+                throw std::runtime_error("Некорректный статус документа в снимке: "s + it->second);
+            }
+            const int rating = reader.ReadInt32();
+            TokenizedDocument document;
+            document.length = reader.ReadInt32();
+            const uint32_t word_count = reader.ReadUint32();
+            for (uint32_t j = 0; j < word_count; ++j) {
+                const std::string_view word = reader.ReadString();
+                document.word_frequencies.emplace_hint(document.word_frequencies.end(), word, reader.ReadDouble());
+            }
+            search_server_.AddTokenizedDocument(document_id, std::move(document), static_cast<DocumentStatus>(status), {rating});
+        }
+        return;
+    }
+}
+
+void DurableSearchServer::ReplayLog() {
+    std::vector<LogRecord> records = WriteAheadLog::ReadRecords(directory_, snapshot_lsn_ + 1);
+    // Разбор текстов не зависит от состояния индекса и выполняется параллельно,
+    // а изменения применяются по порядку номеров записей
+    std::vector<TokenizedDocument> documents(records.size());
+    std::transform(std::execution::par, records.begin(), records.end(), documents.begin(),
+        [this](const LogRecord& record) {
+            if (record.type != LogRecordType::ADD_DOCUMENT) {
+                return TokenizedDocument();
+            }
+            return search_server_.TokenizeDocument(record.text);
+        });
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (records[i].type == LogRecordType::ADD_DOCUMENT) {
+            search_server_.AddTokenizedDocument(records[i].document_id, std::move(documents[i]), records[i].status, records[i].ratings);
+        } else {
+            search_server_.RemoveDocument(records[i].document_id);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binary_io.h"
+#include "search_server.h"
+#include "write_ahead_log.h"
+
+// SearchServer с журналом упреждающей записи и снимками. Изменение применяется к индексу
+// только после записи в журнал на диске; хранятся два последних снимка и журнал после предыдущего
+class DurableSearchServer {
+public:
+    // search_server задаёт стоп-слова и должен быть пустым; каталог должен существовать
+    DurableSearchServer(SearchServer search_server, std::string directory, WriteAheadLogOptions options = {});
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+
+    void Checkpoint();
+
+    // Вызывает function(const SearchServer&), не допуская одновременных изменений индекса
+    template <typename Function>
+    auto Read(Function function) const;
+
+    const WriteAheadLog& GetLog() const;
+    // Номер последней записи журнала, вошедшей в снимок, 0 — снимка нет
+    uint64_t GetSnapshotLsn() const;
+
+private:
+    const std::string directory_;
+    SearchServer search_server_;
+    WriteAheadLog log_;
+    mutable std::shared_mutex index_mutex_;
+    mutable std::mutex checkpoint_mutex_;
+    uint64_t snapshot_lsn_ = 0;
+
+    // Защищает pending_document_ids_: проверка изменения и его запись в журнал
+    // выполняются под write_mutex_
+    std::mutex write_mutex_;
+    std::condition_variable pending_condition_;
+    // id документов, изменения которых записаны в журнал, но ещё не применены к индексу
+    std::set<int> pending_document_ids_;
+    // Checkpoint ждёт применения записанных изменений, и новые изменения не добавляются
+    bool is_checkpoint_waiting_ = false;
+
+    // Проверяет изменение по индексу, добавляет его в журнал и резервирует id документа
+    uint64_t AppendRecord(LogRecord record);
+    void ReleaseDocumentId(int document_id);
+
+    void LoadSnapshot();
+    void ReplayLog();
+    BinaryWriter SerializeSnapshot(uint64_t lsn) const;
+};
+
+template <typename Function>
+auto DurableSearchServer::Read(Function function) const {
+    std::shared_lock lock(index_mutex_);
+    return function(search_server_);
+}
@@ -0,0 +1,156 @@
+#include "durable_search_server.h"
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Восстановление DurableSearchServer после сбоев, смоделированных правкой файлов каталога
+
+namespace fs = filesystem;
+
+string MakeEmptyDirectory(const string& name) {
+    const fs::path path = fs::temp_directory_path() / ("durable_search_server_test-"s + name);
+    fs::remove_all(path);
+    fs::create_directories(path);
+    return path.string();
+}
+
+// Файлы каталога с заданным префиксом по возрастанию номера в имени
+vector<string> ListFiles(const string& directory, const string& prefix) {
+    map<string, string> files;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        const string name = entry.path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            files.emplace(name, entry.path().string());
+        }
+    }
+    vector<string> paths;
+    for (const auto& [_, path] : files) {
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+void AppendBytes(const string& path, const string& bytes) {
+    ofstream out(path, ios::binary | ios::app);
+    out << bytes;
+}
+
+void ChangeByte(const string& path, size_t offset) {
+    fstream file(path, ios::binary | ios::in | ios::out);
+    file.seekg(offset);
+    const char byte = static_cast<char>(file.get() ^ 0x5A);
+    file.seekp(offset);
+    file.put(byte);
+}
+
+DurableSearchServer Open(const string& directory, WriteAheadLogOptions options = {}) {
+    return DurableSearchServer(SearchServer(""s), directory, options);
+}
+
+void AddDocuments(DurableSearchServer& server, int first_id, int count) {
+    for (int id = first_id; id < first_id + count; ++id) {
+        server.AddDocument(id, "cat dog number"s + to_string(id), DocumentStatus::ACTUAL, {id % 5});
+    }
+}
+
+int GetDocumentCount(const DurableSearchServer& server) {
+    return server.Read([](const SearchServer& search_server) {
+        return search_server.GetDocumentCount();
+    });
+}
+
+void TestTornTailIsDropped() {
+    const string directory = MakeEmptyDirectory("torn-tail"s);
+    {
+        DurableSearchServer server = Open(directory);
+        AddDocuments(server, 0, 10);
+    }
+    // Начало записи, оборванной при сбое: заголовок обещает больше данных, чем есть
+    AppendBytes(ListFiles(directory, "wal-"s).back(), "\x40\x00\x00\x00\x12\x34\x56\x78partial"s);
+    {
+        DurableSearchServer server = Open(directory);
+        assert(GetDocumentCount(server) == 10);
+        AddDocuments(server, 10, 1);
+    }
+    DurableSearchServer server = Open(directory);
+    assert(GetDocumentCount(server) == 11);
+    assert(server.GetLog().GetLastLsn() == 11);
+}
+
+void TestDamageBeforeWholeRecordsIsReported() {
+    const string directory = MakeEmptyDirectory("damaged-middle"s);
+    {
+        DurableSearchServer server = Open(directory);
+        AddDocuments(server, 0, 10);
+    }
+    // Байт содержимого первой записи: за ней остаются девять целых записей
+    ChangeByte(ListFiles(directory, "wal-"s).back(), 12);
+    try {
+        Open(directory);
+        assert(false);
+    } catch (const runtime_error&) {
+    }
+}
+
+void TestDamagedSnapshotFallsBackToPrevious() {
+    const string directory = MakeEmptyDirectory("snapshot-fallback"s);
+    {
+        DurableSearchServer server = Open(directory);
+        AddDocuments(server, 0, 10);
+        server.Checkpoint();
+        AddDocuments(server, 10, 10);
+        server.RemoveDocument(3);
+        server.Checkpoint();
+        AddDocuments(server, 20, 5);
+    }
+    const vector<string> snapshots = ListFiles(directory, "snapshot-"s);
+    assert(snapshots.size() == 2);
+    ChangeByte(snapshots.back(), 16);
+    DurableSearchServer server = Open(directory);
+    assert(server.GetSnapshotLsn() == 10);
+    assert(GetDocumentCount(server) == 24);
+    server.Read([](const SearchServer& search_server) {
+        assert(search_server.FindTopDocuments("number3"s).empty());
+        assert(search_server.FindTopDocuments("number24"s).size() == 1);
+        return 0;
+    });
+}
+
+void TestCheckpointKeepsLogBackToPreviousSnapshot() {
+    const string directory = MakeEmptyDirectory("truncate"s);
+    // Маленькие сегменты: почти каждая запись начинает новый
+    const WriteAheadLogOptions options{64};
+    {
+        DurableSearchServer server = Open(directory, options);
+        AddDocuments(server, 0, 20);
+        server.Checkpoint();
+        AddDocuments(server, 20, 20);
+        server.Checkpoint();
+        AddDocuments(server, 40, 20);
+        server.Checkpoint();
+    }
+    // Остаются сегменты с записями после предыдущего снимка (номер 40)
+    const vector<string> segments = ListFiles(directory, "wal-"s);
+    assert(!segments.empty());
+    assert(segments.front() > directory + "/wal-00000000000000000020.log"s);
+    assert(segments.front() <= directory + "/wal-00000000000000000041.log"s);
+    // Без последнего снимка сервер восстанавливается из предыдущего и журнала
+    fs::remove(ListFiles(directory, "snapshot-"s).back());
+    DurableSearchServer server = Open(directory, options);
+    assert(server.GetSnapshotLsn() == 40);
+    assert(GetDocumentCount(server) == 60);
+}
+
+int main() {
+    TestTornTailIsDropped();
+    TestDamageBeforeWholeRecordsIsReported();
+    TestDamagedSnapshotFallsBackToPrevious();
+    TestCheckpointKeepsLogBackToPreviousSnapshot();
+    cout << "OK"s << endl;
+}
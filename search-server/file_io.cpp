@@ -0,0 +1,115 @@
+#include "file_io.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std::string_literals;
+
+namespace {
+
+[[noreturn]] void ThrowFileError(const std::string& what, const std::string& path) {
+    throw std::runtime_error(what + " "s + path + ": "s + std::strerror(errno));
+}
+
+}
+
+AppendFile::AppendFile(const std::string& path)
+    : fd_(open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644))
+    , path_(path)
+{
+    if (fd_ < 0) {
+        ThrowFileError("Не удалось открыть"s, path_);
+    }
+    struct stat file_stat{};
+    if (fstat(fd_, &file_stat) != 0) {
+        ThrowFileError("Не удалось прочитать размер"s, path_);
+    }
+    size_ = file_stat.st_size;
+}
+
+AppendFile::AppendFile(AppendFile&& other) noexcept
+    : fd_(other.fd_)
+    , path_(std::move(other.path_))
+    , size_(other.size_)
+{
+    other.fd_ = -1;
+}
+
+AppendFile& AppendFile::operator=(AppendFile&& other) noexcept {
+    if (this != &other) {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+        fd_ = other.fd_;
+        path_ = std::move(other.path_);
+        size_ = other.size_;
+        other.fd_ = -1;
+    }
+    return *this;
+}
+
+AppendFile::~AppendFile() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+void AppendFile::Append(std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t written = write(fd_, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ThrowFileError("Не удалось записать"s, path_);
+        }
+        data.remove_prefix(written);
+        size_ += written;
+    }
+}
+
+void AppendFile::Sync() {
+    if (fdatasync(fd_) != 0) {
+        ThrowFileError("Не удалось сохранить на диск"s, path_);
+    }
+}
+
+void AppendFile::Truncate(uint64_t size) {
+    if (ftruncate(fd_, size) != 0) {
+        ThrowFileError("Не удалось обрезать"s, path_);
+    }
+    size_ = size;
+}
+
+uint64_t AppendFile::GetSize() const {
+    return size_;
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Не удалось открыть "s + path);
+    }
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+void SyncDirectory(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        ThrowFileError("Не удалось открыть каталог"s, path);
+    }
+    const int result = fsync(fd);
+    close(fd);
+    if (result != 0) {
+        ThrowFileError("Не удалось сохранить каталог"s, path);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Файл, открытый для дозаписи; при ошибках бросает std::runtime_error
+class AppendFile {
+public:
+    explicit AppendFile(const std::string& path);
+    AppendFile(AppendFile&& other) noexcept;
+    AppendFile& operator=(AppendFile&& other) noexcept;
+    AppendFile(const AppendFile&) = delete;
+    AppendFile& operator=(const AppendFile&) = delete;
+    ~AppendFile();
+
+    void Append(std::string_view data);
+    // Дожидается записи данных на диск (fdatasync)
+    void Sync();
+    // Отбрасывает данные после size байт
+    void Truncate(uint64_t size);
+
+    uint64_t GetSize() const;
+
+private:
+    int fd_ = -1;
+    std::string path_;
+    uint64_t size_ = 0;
+};
+
+std::string ReadFile(const std::string& path);
+
+// Записывает на диск изменения каталога: созданные, переименованные и удалённые файлы
+void SyncDirectory(const std::string& path);
@@ -0,0 +1,44 @@
+#include "impact_postings_cache.h"
+
+#include <algorithm>
+
+ImpactPostingsCache::ImpactPostingsCache(const ImpactPostingsCache&) {
+}
+
+ImpactPostingsCache& ImpactPostingsCache::operator=(const ImpactPostingsCache& other) {
+    if (this != &other) {
+        std::lock_guard guard(mutex_);
+        postings_.clear();
+    }
+    return *this;
+}
+
+std::shared_ptr<const ImpactPostings> ImpactPostingsCache::Get(std::string_view word, const std::map<int, double>& document_freqs) const {
+    {
+        std::lock_guard guard(mutex_);
+        const auto it = postings_.find(word);
+        if (it != postings_.end()) {
+            return it->second;
+        }
+    }
+    // Список строится без блокировки: другие слова в это время читаются из кэша
+    auto postings = std::make_shared<ImpactPostings>();
+    postings->reserve(document_freqs.size());
+    for (const auto [document_id, term_freq] : document_freqs) {
+        postings->emplace_back(term_freq, document_id);
+    }
+    std::sort(postings->begin(), postings->end(), std::greater<>());
+    std::lock_guard guard(mutex_);
+    return postings_.emplace(std::string(word), std::move(postings)).first->second;
+}
+
+void ImpactPostingsCache::Invalidate(std::string_view word) {
+    std::lock_guard guard(mutex_);
+    if (postings_.empty()) {
+        return;
+    }
+    const auto it = postings_.find(word);
+    if (it != postings_.end()) {
+        postings_.erase(it);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Список документов слова (term_freq, id), упорядоченный по убыванию term_freq
+using ImpactPostings = std::vector<std::pair<double, int>>;
+
+// Списки документов слов по убыванию term_freq; строятся при первом запросе слова
+// и сбрасываются при его изменении. Get можно вызывать из нескольких потоков
+class ImpactPostingsCache {
+public:
+    ImpactPostingsCache() = default;
+    ImpactPostingsCache(const ImpactPostingsCache&);
+    ImpactPostingsCache& operator=(const ImpactPostingsCache&);
+
+    std::shared_ptr<const ImpactPostings> Get(std::string_view word, const std::map<int, double>& document_freqs) const;
+    void Invalidate(std::string_view word);
+
+private:
+    mutable std::mutex mutex_;
+    mutable std::map<std::string, std::shared_ptr<const ImpactPostings>, std::less<>> postings_;
+};
@@ -0,0 +1,297 @@
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std::string_literals;
+
+namespace {
+
+struct ThreadData {
+    std::array<std::array<std::atomic<uint64_t>, HdrHistogram::BUCKETS_COUNT>, SEARCH_STAGES_COUNT> stage_buckets{};
+    std::array<std::atomic<uint64_t>, SEARCH_STAGES_COUNT> stage_totals{};
+    std::array<std::atomic<uint64_t>, SEARCH_STAGES_COUNT> stage_max{};
+    std::array<std::atomic<uint64_t>, SEARCH_COUNTERS_COUNT> counters{};
+    // Поколение Reset, к которому относятся данные
+    std::atomic<uint64_t> generation{0};
+};
+
+// Данные потока пишет только сам поток, поэтому вместо fetch_add
+// достаточно пары relaxed load/store, а читатели снимка не видят гонок.
+void Increase(std::atomic<uint64_t>& value, uint64_t delta) {
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+// Reset не трогает данные работающих потоков, а увеличивает поколение:
+// поток сам обнуляет свои данные при следующей записи, а до этого снимок их пропускает
+std::atomic<uint64_t> reset_generation{0};
+
+std::mutex registry_mutex;
+// Данные работающих потоков
+std::vector<std::unique_ptr<ThreadData>> registry;
+// Сумма данных завершившихся потоков; изменяется только под registry_mutex
+ThreadData retired;
+
+void Clear(ThreadData& data) {
+    for (size_t stage = 0; stage < SEARCH_STAGES_COUNT; ++stage) {
+        for (auto& bucket : data.stage_buckets[stage]) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        data.stage_totals[stage].store(0, std::memory_order_relaxed);
+        data.stage_max[stage].store(0, std::memory_order_relaxed);
+    }
+    for (auto& counter : data.counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool IsCurrent(const ThreadData& data) {
+    return data.generation.load(std::memory_order_acquire) == reset_generation.load(std::memory_order_acquire);
+}
+
+void MergeInto(ThreadData& target, const ThreadData& source) {
+    for (size_t stage = 0; stage < SEARCH_STAGES_COUNT; ++stage) {
+        for (size_t i = 0; i < HdrHistogram::BUCKETS_COUNT; ++i) {
+            Increase(target.stage_buckets[stage][i], source.stage_buckets[stage][i].load(std::memory_order_relaxed));
+        }
+        Increase(target.stage_totals[stage], source.stage_totals[stage].load(std::memory_order_relaxed));
+        const uint64_t max = source.stage_max[stage].load(std::memory_order_relaxed);
+        if (target.stage_max[stage].load(std::memory_order_relaxed) < max) {
+            target.stage_max[stage].store(max, std::memory_order_relaxed);
+        }
+    }
+    for (size_t counter = 0; counter < SEARCH_COUNTERS_COUNT; ++counter) {
+        Increase(target.counters[counter], source.counters[counter].load(std::memory_order_relaxed));
+    }
+}
+
+// Регистрирует данные потока и при завершении потока переносит их в retired,
+// чтобы память потоков, которые приходят и уходят, не накапливалась
+class ThreadDataHolder {
+public:
+    ThreadDataHolder() {
+        std::lock_guard guard(registry_mutex);
+        registry.push_back(std::make_unique<ThreadData>());
+        data_ = registry.back().get();
+        data_->generation.store(reset_generation.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    ~ThreadDataHolder() {
+        std::lock_guard guard(registry_mutex);
+        if (IsCurrent(*data_)) {
+            MergeInto(retired, *data_);
+        }
+        const auto it = std::find_if(registry.begin(), registry.end(), [this](const auto& data) {
+            return data.get() == data_;
+        });
+        std::swap(*it, registry.back());
+        registry.pop_back();
+    }
+
+    ThreadDataHolder(const ThreadDataHolder&) = delete;
+    ThreadDataHolder& operator=(const ThreadDataHolder&) = delete;
+
+    ThreadData& Get() {
+        return *data_;
+    }
+
+private:
+    ThreadData* data_;
+};
+
+ThreadData& GetThreadData() {
+    thread_local ThreadDataHolder holder;
+    ThreadData& data = holder.Get();
+    const uint64_t generation = reset_generation.load(std::memory_order_acquire);
+    if (data.generation.load(std::memory_order_relaxed) != generation) {
+        Clear(data);
+        data.generation.store(generation, std::memory_order_release);
+    }
+    return data;
+}
+
+int FloorLog2(uint64_t value) {
+    int result = 0;
+    for (int shift = 32; shift > 0; shift /= 2) {
+        if (value >> shift) {
+            value >>= shift;
+            result += shift;
+        }
+    }
+    return result;
+}
+
+}
+
+const char* GetStageName(SearchStage stage) {
+    switch (stage) {
+        case SearchStage::PARSE: return "parse";
+        case SearchStage::POSTING_SCAN: return "posting_scan";
+        case SearchStage::MINUS_FILTER: return "minus_filter";
+        case SearchStage::TOP_K: return "top_k";
+        case SearchStage::MATCH: return "match";
+    }
+    return "unknown";
+}
+
+const char* GetCounterName(SearchCounter counter) {
+    switch (counter) {
+        case SearchCounter::POSTINGS_TOUCHED: return "postings_touched";
+        case SearchCounter::DOCUMENTS_SCORED: return "documents_scored";
+    }
+    return "unknown";
+}
+
+size_t HdrHistogram::GetBucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS_COUNT) {
+        return value;
+    }
+    const int exponent = FloorLog2(value);
+    const uint64_t sub_bucket = (value >> (exponent - SUB_BUCKET_BITS)) - SUB_BUCKETS_COUNT;
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS_COUNT + sub_bucket;
+}
+
+uint64_t HdrHistogram::GetBucketValue(size_t index) {
+    if (index < SUB_BUCKETS_COUNT) {
+        return index;
+    }
+    const int exponent = static_cast<int>(index / SUB_BUCKETS_COUNT) + SUB_BUCKET_BITS - 1;
+    const uint64_t sub_bucket = index % SUB_BUCKETS_COUNT;
+    return (SUB_BUCKETS_COUNT + sub_bucket) << (exponent - SUB_BUCKET_BITS);
+}
+
+void HdrHistogram::Add(uint64_t value, uint64_t count) {
+    buckets_[GetBucketIndex(value)] += count;
+    count_ += count;
+    total_ += value * count;
+    max_ = std::max(max_, value);
+}
+
+void HdrHistogram::AddToBucket(size_t index, uint64_t count) {
+    buckets_.at(index) += count;
+    count_ += count;
+}
+
+void HdrHistogram::AddSummary(uint64_t total, uint64_t max) {
+    total_ += total;
+    max_ = std::max(max_, max);
+}
+
+void HdrHistogram::Merge(const HdrHistogram& other) {
+    for (size_t i = 0; i < BUCKETS_COUNT; ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    total_ += other.total_;
+    max_ = std::max(max_, other.max_);
+}
+
+uint64_t HdrHistogram::GetCount() const {
+    return count_;
+}
+
+uint64_t HdrHistogram::GetTotal() const {
+    return total_;
+}
+
+uint64_t HdrHistogram::GetMax() const {
+    return max_;
+}
+
+uint64_t HdrHistogram::GetValueAtPercentile(double percentile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    const double clamped = std::clamp(percentile, 0.0, 100.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped / 100.0 * count_ + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS_COUNT; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            const uint64_t upper = (i + 1 < BUCKETS_COUNT) ? GetBucketValue(i + 1) - 1 : max_;
+            return std::min(upper, max_);
+        }
+    }
+    return max_;
+}
+
+const HdrHistogram& InstrumentationSnapshot::GetStage(SearchStage stage) const {
+    return stages[static_cast<size_t>(stage)];
+}
+
+uint64_t InstrumentationSnapshot::GetCounter(SearchCounter counter) const {
+    return counters[static_cast<size_t>(counter)];
+}
+
+void Instrumentation::RecordStage(SearchStage stage, std::chrono::nanoseconds duration) {
+    ThreadData& data = GetThreadData();
+    const size_t stage_index = static_cast<size_t>(stage);
+    const uint64_t value = std::max<int64_t>(duration.count(), 0);
+    Increase(data.stage_buckets[stage_index][HdrHistogram::GetBucketIndex(value)], 1);
+    Increase(data.stage_totals[stage_index], value);
+    if (data.stage_max[stage_index].load(std::memory_order_relaxed) < value) {
+        data.stage_max[stage_index].store(value, std::memory_order_relaxed);
+    }
+}
+
+void Instrumentation::AddCounter(SearchCounter counter, uint64_t value) {
+    Increase(GetThreadData().counters[static_cast<size_t>(counter)], value);
+}
+
+InstrumentationSnapshot Instrumentation::GetSnapshot() {
+    InstrumentationSnapshot snapshot;
+    std::lock_guard guard(registry_mutex);
+    std::vector<const ThreadData*> all_data = {&retired};
+    for (const auto& data : registry) {
+        if (IsCurrent(*data)) {
+            all_data.push_back(data.get());
+        }
+    }
+    for (const ThreadData* data : all_data) {
+        for (size_t stage = 0; stage < SEARCH_STAGES_COUNT; ++stage) {
+            HdrHistogram thread_histogram;
+            for (size_t i = 0; i < HdrHistogram::BUCKETS_COUNT; ++i) {
+                const uint64_t count = data->stage_buckets[stage][i].load(std::memory_order_relaxed);
+                if (count > 0) {
+                    thread_histogram.AddToBucket(i, count);
+                }
+            }
+            thread_histogram.AddSummary(data->stage_totals[stage].load(std::memory_order_relaxed),
+                                        data->stage_max[stage].load(std::memory_order_relaxed));
+            snapshot.stages[stage].Merge(thread_histogram);
+        }
+        for (size_t counter = 0; counter < SEARCH_COUNTERS_COUNT; ++counter) {
+            snapshot.counters[counter] += data->counters[counter].load(std::memory_order_relaxed);
+        }
+    }
+    return snapshot;
+}
+
+void Instrumentation::Reset() {
+    std::lock_guard guard(registry_mutex);
+    Clear(retired);
+    reset_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void PrintSnapshot(std::ostream& out, const InstrumentationSnapshot& snapshot) {
+    out << "{\"stages\": {"s;
+    for (size_t stage = 0; stage < SEARCH_STAGES_COUNT; ++stage) {
+        const HdrHistogram& histogram = snapshot.stages[stage];
+        out << (stage ? ", "s : ""s) << '"' << GetStageName(static_cast<SearchStage>(stage)) << "\": {"s
+            << "\"count\": "s << histogram.GetCount()
+            << ", \"total_ns\": "s << histogram.GetTotal()
+            << ", \"p50_ns\": "s << histogram.GetValueAtPercentile(50)
+            << ", \"p90_ns\": "s << histogram.GetValueAtPercentile(90)
+            << ", \"p99_ns\": "s << histogram.GetValueAtPercentile(99)
+            << ", \"p999_ns\": "s << histogram.GetValueAtPercentile(99.9)
+            << ", \"max_ns\": "s << histogram.GetMax() << '}';
+    }
+    out << "}, \"counters\": {"s;
+    for (size_t counter = 0; counter < SEARCH_COUNTERS_COUNT; ++counter) {
+        out << (counter ? ", "s : ""s) << '"' << GetCounterName(static_cast<SearchCounter>(counter)) << "\": "s
+            << snapshot.counters[counter];
+    }
+    out << "}}"s;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include "log_duration.h"
+
+// Время стадий поиска и счётчики по потокам; с SEARCH_SERVER_DISABLE_INSTRUMENTATION
+// макросы LOG_STAGE и ADD_COUNTER ничего не делают
+#ifdef SEARCH_SERVER_DISABLE_INSTRUMENTATION
+#define LOG_STAGE(x) do {} while (false)
+#define ADD_COUNTER(x, y) do {} while (false)
+#else
+#define LOG_STAGE(x) StageDuration UNIQUE_VAR_NAME_PROFILE(x)
+#define ADD_COUNTER(x, y) Instrumentation::AddCounter(x, y)
+#endif
+
+enum class SearchStage {
+    PARSE,
+    POSTING_SCAN,
+    MINUS_FILTER,
+    TOP_K,
+    MATCH,
+};
+
+enum class SearchCounter {
+    POSTINGS_TOUCHED,
+    DOCUMENTS_SCORED,
+};
+
+constexpr size_t SEARCH_STAGES_COUNT = 5;
+constexpr size_t SEARCH_COUNTERS_COUNT = 2;
+
+const char* GetStageName(SearchStage stage);
+const char* GetCounterName(SearchCounter counter);
+
+// Логарифмически-линейная гистограмма: значения меньше SUB_BUCKETS_COUNT
+// хранятся точно, остальные с относительной погрешностью не хуже 1/SUB_BUCKETS_COUNT.
+class HdrHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS_COUNT = 1ull << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKETS_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS_COUNT;
+
+    static size_t GetBucketIndex(uint64_t value);
+    static uint64_t GetBucketValue(size_t index);
+
+    void Add(uint64_t value, uint64_t count = 1);
+    // Для сборки гистограммы из готовых корзин: сумма и максимум задаются отдельно.
+    void AddToBucket(size_t index, uint64_t count);
+    void AddSummary(uint64_t total, uint64_t max);
+    void Merge(const HdrHistogram& other);
+
+    uint64_t GetCount() const;
+    uint64_t GetTotal() const;
+    uint64_t GetMax() const;
+    uint64_t GetValueAtPercentile(double percentile) const;
+
+private:
+    std::array<uint64_t, BUCKETS_COUNT> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t total_ = 0;
+    uint64_t max_ = 0;
+};
+
+struct InstrumentationSnapshot {
+    std::array<HdrHistogram, SEARCH_STAGES_COUNT> stages;
+    std::array<uint64_t, SEARCH_COUNTERS_COUNT> counters{};
+
+    const HdrHistogram& GetStage(SearchStage stage) const;
+    uint64_t GetCounter(SearchCounter counter) const;
+};
+
+class Instrumentation {
+public:
+    static void RecordStage(SearchStage stage, std::chrono::nanoseconds duration);
+    static void AddCounter(SearchCounter counter, uint64_t value);
+
+    static InstrumentationSnapshot GetSnapshot();
+    static void Reset();
+};
+
+// Выводит снимок в поток одной JSON-строкой: для каждой стадии число замеров,
+// суммарное время и перцентили в наносекундах, затем значения счётчиков.
+void PrintSnapshot(std::ostream& out, const InstrumentationSnapshot& snapshot);
+
+class StageDuration {
+public:
+    using Clock = LogDuration::Clock;
+
+    explicit StageDuration(SearchStage stage)
+        : stage_(stage) {
+    }
+
+    StageDuration(const StageDuration&) = delete;
+    StageDuration& operator=(const StageDuration&) = delete;
+
+    ~StageDuration() {
+        Instrumentation::RecordStage(stage_, Clock::now() - start_time_);
+    }
+
+private:
+    const SearchStage stage_;
+    const Clock::time_point start_time_ = Clock::now();
+};
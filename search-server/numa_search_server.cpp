@@ -0,0 +1,186 @@
+#include "numa_search_server.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+NumaSearchServer::NumaSearchServer(const SearchServer& search_server, NumaOptions options)
+    : topology_(options.emulated_node_count == 0 ? NumaTopology::Detect() : NumaTopology::Emulate(options.emulated_node_count))
+    , options_(options)
+{
+    if (!options_.replicate_index) {
+        replicas_.push_back(std::make_unique<const SearchServer>(search_server));
+    } else {
+        // Память копии выделяет и впервые заполняет поток узла, поэтому
+        // ядро размещает её страницы на этом узле
+        replicas_.resize(topology_.GetNodeCount());
+        std::vector<std::thread> builders;
+        std::vector<std::exception_ptr> errors(topology_.GetNodeCount());
+        const auto join_builders = [&builders]() {
+            for (std::thread& builder : builders) {
+                builder.join();
+            }
+        };
+        try {
+            for (size_t node = 0; node < topology_.GetNodeCount(); ++node) {
+                builders.emplace_back([this, &search_server, &errors, node] {
+                    try {
+                        topology_.PinCurrentThread(node);
+                    } catch (const std::runtime_error&) {
+                        // Как и в RunWorker, без закрепления копия всё равно строится
+                    }
+                    try {
+                        topology_.PreferMemoryOnNode(node);
+                        replicas_[node] = std::make_unique<const SearchServer>(search_server);
+                        topology_.ResetMemoryPreference();
+                    } catch (...) {
+                        errors[node] = std::current_exception();
+                    }
+                });
+            }
+        } catch (...) {
+            join_builders();
+            throw;
+        }
+        join_builders();
+        for (const std::exception_ptr& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    for (size_t node = 0; node < topology_.GetNodeCount(); ++node) {
+        const size_t thread_count = options_.threads_per_node == 0
+            ? topology_.GetNodeCpus(node).size()
+            : options_.threads_per_node;
+        node_thread_counts_.push_back(thread_count);
+        for (size_t i = 0; i < thread_count; ++i) {
+            try {
+                threads_.emplace_back(&NumaSearchServer::RunWorker, this, node);
+            } catch (...) {
+                // Деструктор не вызывается для недостроенного объекта
+                StopWorkers();
+                throw;
+            }
+        }
+    }
+}
+
+NumaSearchServer::~NumaSearchServer() {
+    StopWorkers();
+}
+
+void NumaSearchServer::StopWorkers() {
+    {
+        std::lock_guard guard(mutex_);
+        is_stopping_ = true;
+    }
+    batch_condition_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+std::vector<std::vector<Document>> NumaSearchServer::ProcessQueries(const std::vector<std::string>& queries) const {
+    std::lock_guard process_guard(process_mutex_);
+    std::vector<std::vector<Document>> results(queries.size());
+    Batch batch;
+    batch.queries = &queries;
+    batch.results = &results;
+    batch.running_thread_count = threads_.size();
+    // Узел получает непрерывный диапазон запросов пропорционально числу своих потоков
+    batch.node_queries = std::vector<NodeQueries>(topology_.GetNodeCount());
+    const size_t thread_count = std::max<size_t>(threads_.size(), 1);
+    size_t assigned_thread_count = 0;
+    for (size_t node = 0; node < batch.node_queries.size(); ++node) {
+        batch.node_queries[node].next_query = queries.size() * assigned_thread_count / thread_count;
+        assigned_thread_count += node_thread_counts_[node];
+        batch.node_queries[node].end_query = queries.size() * assigned_thread_count / thread_count;
+    }
+    {
+        std::lock_guard guard(mutex_);
+        batch_ = &batch;
+        ++batch_number_;
+    }
+    batch_condition_.notify_all();
+    std::unique_lock lock(mutex_);
+    done_condition_.wait(lock, [&batch] { return batch.running_thread_count == 0; });
+    batch_ = nullptr;
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+    return results;
+}
+
+const SearchServer& NumaSearchServer::GetReplica(size_t node) const {
+    if (node >= topology_.GetNodeCount()) {
+        throw std::out_of_range("Нет узла NUMA с номером "s + std::to_string(node));
+    }
+    return *replicas_[options_.replicate_index ? node : 0];
+}
+
+const SearchServer& NumaSearchServer::GetLocalReplica() const {
+    return GetReplica(topology_.GetCurrentNode());
+}
+
+const NumaTopology& NumaSearchServer::GetTopology() const {
+    return topology_;
+}
+
+size_t NumaSearchServer::GetThreadCount() const {
+    return threads_.size();
+}
+
+void NumaSearchServer::RunWorker(size_t node) {
+    try {
+        topology_.PinCurrentThread(node);
+    } catch (const std::runtime_error&) {
+        // Закрепление — только оптимизация: без него поток работает с той же копией
+    }
+    const SearchServer& replica = GetReplica(node);
+    uint64_t processed_batch_number = 0;
+    while (true) {
+        Batch* batch = nullptr;
+        {
+            std::unique_lock lock(mutex_);
+            batch_condition_.wait(lock, [this, processed_batch_number] {
+                return is_stopping_ || batch_number_ != processed_batch_number;
+            });
+            if (is_stopping_) {
+                return;
+            }
+            processed_batch_number = batch_number_;
+            batch = batch_;
+        }
+        // Сначала поток берёт запросы своего узла, а закончив их, забирает
+        // оставшиеся у других узлов, чтобы медленный узел не задерживал весь пакет
+        for (size_t i = 0; i < batch->node_queries.size(); ++i) {
+            ProcessNodeQueries(*batch, batch->node_queries[(node + i) % batch->node_queries.size()], replica);
+        }
+        {
+            std::lock_guard guard(mutex_);
+            if (--batch->running_thread_count == 0) {
+                done_condition_.notify_one();
+            }
+        }
+    }
+}
+
+void NumaSearchServer::ProcessNodeQueries(Batch& batch, NodeQueries& node_queries, const SearchServer& replica) const {
+    for (size_t i = node_queries.next_query++; i < node_queries.end_query; i = node_queries.next_query++) {
+        try {
+            (*batch.results)[i] = replica.FindTopDocuments((*batch.queries)[i]);
+        } catch (...) {
+            std::lock_guard guard(mutex_);
+            if (!batch.error) {
+                batch.error = std::current_exception();
+            }
+            // Остальные запросы пакета не обрабатываются
+            for (NodeQueries& queries : batch.node_queries) {
+                queries.next_query = queries.end_query;
+            }
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "numa_topology.h"
+#include "search_server.h"
+
+struct NumaOptions {
+    // Число эмулируемых узлов NUMA, 0 — настоящие узлы машины
+    size_t emulated_node_count = 0;
+    // Потоков обработки запросов на узел, 0 — по числу процессоров узла
+    size_t threads_per_node = 0;
+    // false — все узлы читают одну копию индекса, для сравнения с репликацией
+    bool replicate_index = true;
+};
+
+// Копия индекса на каждом узле NUMA и потоки узлов для ProcessQueries.
+// Копии не обновляются: после изменения исходного сервера объект создаётся заново
+class NumaSearchServer {
+public:
+    explicit NumaSearchServer(const SearchServer& search_server, NumaOptions options = {});
+    ~NumaSearchServer();
+
+    NumaSearchServer(const NumaSearchServer&) = delete;
+    NumaSearchServer& operator=(const NumaSearchServer&) = delete;
+
+    // Результаты в порядке запросов, как у ProcessQueries(const SearchServer&, ...).
+    // Исключение, брошенное для какого-либо запроса, передаётся вызывающему.
+    std::vector<std::vector<Document>> ProcessQueries(const std::vector<std::string>& queries) const;
+
+    const SearchServer& GetReplica(size_t node) const;
+    // Копия узла, на котором выполняется текущий поток: для собственных потоков
+    // вызывающего, закреплённых через GetTopology(). Параллельные версии методов
+    // SearchServer и ProcessQueries(const SearchServer&, ...) копии узлов не используют
+    const SearchServer& GetLocalReplica() const;
+
+    const NumaTopology& GetTopology() const;
+    size_t GetThreadCount() const;
+
+private:
+    // Запросы пакета, назначенные одному узлу. Счётчик в своей строке кеша:
+    // пока у узла есть запросы, его потоки не обращаются к памяти других узлов
+    struct alignas(64) NodeQueries {
+        std::atomic<size_t> next_query = 0;
+        size_t end_query = 0;
+    };
+
+    // Пакет запросов, который делят потоки всех узлов
+    struct Batch {
+        const std::vector<std::string>* queries = nullptr;
+        std::vector<std::vector<Document>>* results = nullptr;
+        std::vector<NodeQueries> node_queries;
+        size_t running_thread_count = 0;
+        // Первое исключение, брошенное при обработке запросов
+        std::exception_ptr error;
+    };
+
+    const NumaTopology topology_;
+    const NumaOptions options_;
+    std::vector<std::unique_ptr<const SearchServer>> replicas_;
+    std::vector<size_t> node_thread_counts_;
+
+    // Пакеты обрабатываются по одному
+    mutable std::mutex process_mutex_;
+    mutable std::mutex mutex_;
+    mutable std::condition_variable batch_condition_;
+    mutable std::condition_variable done_condition_;
+    mutable Batch* batch_ = nullptr;
+    mutable uint64_t batch_number_ = 0;
+    bool is_stopping_ = false;
+    std::vector<std::thread> threads_;
+
+    void RunWorker(size_t node);
+    // Обрабатывает запросы узла, пока они не кончатся
+    void ProcessNodeQueries(Batch& batch, NodeQueries& node_queries, const SearchServer& replica) const;
+    // Останавливает и дожидается запущенные рабочие потоки
+    void StopWorkers();
+};
@@ -0,0 +1,177 @@
+#include "numa_topology.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <pthread.h>
+#include <sched.h>
+
+#ifdef SEARCH_SERVER_ENABLE_NUMA
+#include <numa.h>
+#endif
+
+using namespace std::string_literals;
+
+namespace {
+
+std::vector<int> GetAllowedCpus() {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    std::vector<int> cpus;
+    if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &cpu_set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        cpus.push_back(0);
+    }
+    return cpus;
+}
+
+// Разбирает список вида "0-3,8-11"
+std::vector<int> ParseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::istringstream in(text);
+    for (std::string range; std::getline(in, range, ',');) {
+        if (range.empty() || range == "\n"s) {
+            continue;
+        }
+        const size_t dash = range.find('-');
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+}
+
+NumaTopology NumaTopology::Detect() {
+    const std::vector<int> allowed_cpus = GetAllowedCpus();
+    NumaTopology topology;
+    const std::filesystem::path nodes_path = "/sys/devices/system/node"s;
+    std::error_code error;
+    std::vector<int> node_ids;
+    for (const auto& entry : std::filesystem::directory_iterator(nodes_path, error)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() > 4 && name.compare(0, 4, "node"s) == 0
+                && name.find_first_not_of("0123456789"s, 4) == std::string::npos) {
+            node_ids.push_back(std::stoi(name.substr(4)));
+        }
+    }
+    std::sort(node_ids.begin(), node_ids.end());
+    for (const int node_id : node_ids) {
+        std::ifstream in(nodes_path / ("node"s + std::to_string(node_id)) / "cpulist"s);
+        std::string cpu_list;
+        std::getline(in, cpu_list);
+        std::vector<int> cpus;
+        for (const int cpu : ParseCpuList(cpu_list)) {
+            if (std::binary_search(allowed_cpus.begin(), allowed_cpus.end(), cpu)) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (!cpus.empty()) {
+            topology.node_cpus_.push_back(std::move(cpus));
+            topology.system_node_ids_.push_back(node_id);
+        }
+    }
+    if (topology.node_cpus_.empty()) {
+        topology.node_cpus_.push_back(allowed_cpus);
+        topology.system_node_ids_.push_back(0);
+    }
+    topology.BuildCpuIndex();
+    return topology;
+}
+
+NumaTopology NumaTopology::Emulate(size_t node_count) {
+    const std::vector<int> allowed_cpus = GetAllowedCpus();
+    if (node_count == 0) {
+        throw std::invalid_argument("Число узлов должно быть положительным"s);
+    }
+    NumaTopology topology;
+    topology.is_emulated_ = true;
+    topology.node_cpus_.resize(node_count);
+    topology.system_node_ids_.assign(node_count, -1);
+    // Если процессоров меньше, чем узлов, узлы используют процессоры совместно
+    for (size_t node = 0; node < node_count; ++node) {
+        const size_t first = node * allowed_cpus.size() / node_count;
+        const size_t last = std::max(first + 1, (node + 1) * allowed_cpus.size() / node_count);
+        for (size_t i = first; i < last; ++i) {
+            topology.node_cpus_[node].push_back(allowed_cpus[i % allowed_cpus.size()]);
+        }
+    }
+    topology.BuildCpuIndex();
+    return topology;
+}
+
+size_t NumaTopology::GetNodeCount() const {
+    return node_cpus_.size();
+}
+
+const std::vector<int>& NumaTopology::GetNodeCpus(size_t node) const {
+    return node_cpus_.at(node);
+}
+
+bool NumaTopology::IsEmulated() const {
+    return is_emulated_;
+}
+
+size_t NumaTopology::GetCurrentNode() const {
+    const int cpu = sched_getcpu();
+    if (cpu < 0 || static_cast<size_t>(cpu) >= cpu_to_node_.size() || cpu_to_node_[cpu] < 0) {
+        return 0;
+    }
+    return cpu_to_node_[cpu];
+}
+
+void NumaTopology::PinCurrentThread(size_t node) const {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const int cpu : GetNodeCpus(node)) {
+        CPU_SET(cpu, &cpu_set);
+    }
+    const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if (error != 0) {
+        throw std::runtime_error("Не удалось закрепить поток за узлом "s + std::to_string(node));
+    }
+}
+
+void NumaTopology::PreferMemoryOnNode([[maybe_unused]] size_t node) const {
+#ifdef SEARCH_SERVER_ENABLE_NUMA
+    if (!is_emulated_ && numa_available() >= 0) {
+        numa_set_preferred(system_node_ids_.at(node));
+    }
+#endif
+}
+
+void NumaTopology::ResetMemoryPreference() const {
+#ifdef SEARCH_SERVER_ENABLE_NUMA
+    if (!is_emulated_ && numa_available() >= 0) {
+        numa_set_localalloc();
+    }
+#endif
+}
+
+void NumaTopology::BuildCpuIndex() {
+    cpu_to_node_.clear();
+    for (size_t node = 0; node < node_cpus_.size(); ++node) {
+        for (const int cpu : node_cpus_[node]) {
+            if (static_cast<size_t>(cpu) >= cpu_to_node_.size()) {
+                cpu_to_node_.resize(cpu + 1, -1);
+            }
+            // При эмуляции с общими процессорами процессор относится к первому узлу
+            if (cpu_to_node_[cpu] < 0) {
+                cpu_to_node_[cpu] = node;
+            }
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Узлы NUMA процесса из /sys/devices/system/node или эмулированные. PreferMemoryOnNode
+// работает только при сборке с SEARCH_SERVER_ENABLE_NUMA и -lnuma
+class NumaTopology {
+public:
+    static NumaTopology Detect();
+    static NumaTopology Emulate(size_t node_count);
+
+    size_t GetNodeCount() const;
+    const std::vector<int>& GetNodeCpus(size_t node) const;
+    bool IsEmulated() const;
+
+    // Узел, на котором сейчас выполняется текущий поток
+    size_t GetCurrentNode() const;
+
+    // Закрепляет текущий поток за процессорами узла
+    void PinCurrentThread(size_t node) const;
+    // Память, выделяемая текущим потоком, размещается на узле; для эмулируемых
+    // узлов и без libnuma ничего не делает
+    void PreferMemoryOnNode(size_t node) const;
+    void ResetMemoryPreference() const;
+
+private:
+    std::vector<std::vector<int>> node_cpus_;
+    // Номер узла в системе, для libnuma
+    std::vector<int> system_node_ids_;
+    // Номер процессора -> индекс узла, -1 — процессор недоступен
+    std::vector<int> cpu_to_node_;
+    bool is_emulated_ = false;
+
+    void BuildCpuIndex();
+};
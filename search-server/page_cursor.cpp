@@ -0,0 +1,55 @@
+#include "page_cursor.h"
+
+#include <sstream>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+PageCursor::PageCursor(const Document& last_document)
+    : is_start_(false)
+    , last_document_(last_document)
+{
+}
+
+bool PageCursor::IsStart() const {
+    return is_start_;
+}
+
+std::string PageCursor::ToString() const {
+    if (is_start_) {
+        return ""s;
+    }
+    std::ostringstream out;
+    out << std::hexfloat << last_document_.relevance << ':' << last_document_.rating << ':' << last_document_.id;
+    return out.str();
+}
+
+PageCursor PageCursor::FromString(std::string_view text) {
+    if (text.empty()) {
+        return PageCursor();
+    }
+    const size_t first = text.find(':');
+    const size_t second = first == std::string_view::npos ? first : text.find(':', first + 1);
+    if (second == std::string_view::npos) {
+        throw std::invalid_argument("Некорректный курсор страницы"s);
+    }
+    Document last_document;
+    try {
+        size_t parsed = 0;
+        const std::string relevance(text.substr(0, first));
+        const std::string rating(text.substr(first + 1, second - first - 1));
+        const std::string id(text.substr(second + 1));
+        last_document.relevance = std::stod(relevance, &parsed);
+        bool is_valid = parsed == relevance.size();
+        last_document.rating = std::stoi(rating, &parsed);
+        is_valid = is_valid && parsed == rating.size();
+        last_document.id = std::stoi(id, &parsed);
+        is_valid = is_valid && parsed == id.size();
+        if (!is_valid) {
+            throw std::invalid_argument(""s);
+        }
+    } catch (const std::logic_error&) {
+        throw std::invalid_argument("Некорректный курсор страницы"s);
+    }
+    return PageCursor(last_document);
+}
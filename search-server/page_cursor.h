@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+
+// Позиция в выдаче: последний выданный документ. Следующая страница начинается строго после него
+class PageCursor {
+public:
+    PageCursor() = default;
+
+    bool IsStart() const;
+
+    std::string ToString() const;
+    static PageCursor FromString(std::string_view text);
+
+private:
+    friend class SearchServer;
+
+    explicit PageCursor(const Document& last_document);
+
+    bool is_start_ = true;
+    Document last_document_;
+};
+
+struct SearchPage {
+    std::vector<Document> documents;
+    PageCursor next_cursor;
+    bool has_more = false;
+};
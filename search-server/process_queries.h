@@ -3,11 +3,17 @@
 #include <vector>
 #include <list>
 #include "search_server.h"
+#include "numa_search_server.h"
 
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
+// Запросы обрабатываются потоками узлов NUMA, каждый по копии индекса своего узла
+std::vector<std::vector<Document>> ProcessQueries(
+    const NumaSearchServer& search_server,
+    const std::vector<std::string>& queries);
+
 std::list<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
\ No newline at end of file
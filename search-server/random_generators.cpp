@@ -0,0 +1,128 @@
+#include "random_generators.h"
+
+#include <algorithm>
+#include <cmath>
+
+std::string GenerateWord(std::mt19937& generator, int max_length) {
+    const int length = std::uniform_int_distribution(1, max_length)(generator);
+    std::string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(std::uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length) {
+    std::vector<std::string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count, double minus_prob) {
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary, int query_count, int max_word_count) {
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+namespace {
+
+std::vector<double> ComputeZipfWeights(size_t word_count, double exponent) {
+    std::vector<double> weights(word_count);
+    for (size_t rank = 0; rank < word_count; ++rank) {
+        weights[rank] = 1.0 / std::pow(rank + 1.0, exponent);
+    }
+    return weights;
+}
+
+}
+
+ZipfDistribution::ZipfDistribution(size_t word_count, double exponent) {
+    const std::vector<double> weights = ComputeZipfWeights(word_count, exponent);
+    distribution_ = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+}
+
+size_t ZipfDistribution::operator()(std::mt19937& generator) {
+    return distribution_(generator);
+}
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, ZipfDistribution& word_distribution, int word_count, double minus_prob) {
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[word_distribution(generator)];
+    }
+    return query;
+}
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary, ZipfDistribution& word_distribution, int query_count, int word_count, double minus_prob) {
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, word_distribution, word_count, minus_prob));
+    }
+    return queries;
+}
+
+std::vector<std::string> GenerateDocuments(std::mt19937& generator, const std::vector<std::string>& dictionary, ZipfDistribution& word_distribution, int document_count, int median_word_count, double length_sigma) {
+    std::lognormal_distribution<> length_distribution(std::log(std::max(median_word_count, 1)), length_sigma);
+    std::vector<std::string> documents;
+    documents.reserve(document_count);
+    for (int i = 0; i < document_count; ++i) {
+        const int word_count = std::max(1, static_cast<int>(std::lround(length_distribution(generator))));
+        documents.push_back(GenerateQuery(generator, dictionary, word_distribution, word_count));
+    }
+    return documents;
+}
+
+std::vector<std::string> GenerateQueryLog(std::mt19937& generator, const std::vector<std::string>& dictionary, ZipfDistribution& word_distribution, const QueryLogParams& params) {
+    std::geometric_distribution<> extra_words(1.0 / std::max(params.mean_word_count, 1.0));
+    const auto generate_query = [&]() {
+        const int word_count = std::min(params.max_word_count, 1 + extra_words(generator));
+        return GenerateQuery(generator, dictionary, word_distribution, word_count, params.minus_prob);
+    };
+
+    std::vector<std::string> head_queries;
+    head_queries.reserve(params.head_query_count);
+    for (int i = 0; i < params.head_query_count; ++i) {
+        head_queries.push_back(generate_query());
+    }
+    ZipfDistribution head_distribution(head_queries.size(), params.head_exponent);
+
+    std::vector<std::string> queries;
+    queries.reserve(params.query_count);
+    for (int i = 0; i < params.query_count; ++i) {
+        if (!head_queries.empty() && std::uniform_real_distribution<>(0, 1)(generator) < params.head_fraction) {
+            queries.push_back(head_queries[head_distribution(generator)]);
+        } else {
+            queries.push_back(generate_query());
+        }
+    }
+    return queries;
+}
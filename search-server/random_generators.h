@@ -0,0 +1,46 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+std::string GenerateWord(std::mt19937& generator, int max_length);
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length);
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count, double minus_prob = 0);
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary, int query_count, int max_word_count);
+
+// Выбирает номер слова словаря с вероятностью, пропорциональной 1 / (rank + 1)^exponent.
+// При exponent == 0 распределение равномерное.
+class ZipfDistribution {
+public:
+    ZipfDistribution(size_t word_count, double exponent);
+
+    size_t operator()(std::mt19937& generator);
+
+private:
+    std::discrete_distribution<size_t> distribution_;
+};
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, ZipfDistribution& word_distribution, int word_count, double minus_prob = 0);
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary, ZipfDistribution& word_distribution, int query_count, int word_count, double minus_prob = 0);
+
+// Длины документов распределены логнормально с заданной медианой.
+std::vector<std::string> GenerateDocuments(std::mt19937& generator, const std::vector<std::string>& dictionary, ZipfDistribution& word_distribution, int document_count, int median_word_count, double length_sigma);
+
+struct QueryLogParams {
+    int query_count = 10'000;
+    int head_query_count = 100;
+    double head_fraction = 0.3;
+    double head_exponent = 1.0;
+    int max_word_count = 8;
+    double mean_word_count = 2.5;
+    double minus_prob = 0.05;
+};
+
+// Журнал запросов: доля head_fraction приходится на повторы популярных запросов
+// (их частоты тоже подчиняются закону Ципфа), остальные запросы уникальны.
+std::vector<std::string> GenerateQueryLog(std::mt19937& generator, const std::vector<std::string>& dictionary, ZipfDistribution& word_distribution, const QueryLogParams& params);
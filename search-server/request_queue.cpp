@@ -1,14 +1,13 @@
 #include "request_queue.h"
 
-#include <algorithm>
-
 RequestQueue::RequestQueue(const SearchServer& search_server) 
     : search_server_(search_server)
+    , statistics_(min_in_day_)
 {
 }
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
-    return AddFindRequest(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {return document_status == status;});
+    return AddFindRequest(raw_query, DocumentFilter(status));
 }
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query) {
@@ -16,5 +15,9 @@ std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query)
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    return std::count_if(requests_.begin(), requests_.end(), [](const QueryResult& q) {return q.isEmpty;});
+    return statistics_.GetNoResultRequests();
+}
+
+const RequestStatistics& RequestQueue::GetStatistics() const {
+    return statistics_;
 }
\ No newline at end of file
@@ -2,9 +2,10 @@
 
 #include <vector>
 #include <string>
-#include <deque>
+#include <chrono>
 
 #include "search_server.h"
+#include "request_statistics.h"
 
 class RequestQueue {
 public:
@@ -13,9 +14,10 @@ public:
 
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
+        const auto start_time = RequestStatistics::Clock::now();
         std::vector<Document> result = search_server_.FindTopDocuments(raw_query, document_predicate);
-        requests_.push_back({result, result.empty()});
-        if (requests_.size() > min_in_day_) requests_.pop_front();
+        const auto end_time = RequestStatistics::Clock::now();
+        statistics_.AddRequest(end_time, result.size(), end_time - start_time);
         return result;
     }
 
@@ -25,16 +27,13 @@ public:
 
     int GetNoResultRequests() const;
 
-private:
-
-    struct QueryResult {
-        std::vector<Document> result;
-        bool isEmpty;
-    };
+    const RequestStatistics& GetStatistics() const;
 
-    std::deque<QueryResult> requests_;
+private:
 
     const static int min_in_day_ = 1440;
-    
+
     const SearchServer& search_server_;
-};
\ No newline at end of file
+
+    RequestStatistics statistics_;
+};
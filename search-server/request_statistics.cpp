@@ -0,0 +1,233 @@
+#include "request_statistics.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+constexpr uint64_t META_FILLED_BIT = 1ull << 63;
+constexpr uint64_t META_EMPTY_BIT = 1ull << 62;
+constexpr int META_RESULT_COUNT_SHIFT = 32;
+constexpr uint64_t META_RESULT_COUNT_MASK = (1ull << 30) - 1;
+constexpr uint64_t META_LATENCY_MASK = (1ull << 32) - 1;
+
+}
+
+RequestStatistics::RequestStatistics(size_t capacity, Clock::duration time_window)
+    : slots_(std::max<size_t>(capacity, 1))
+    , time_bucket_duration_(std::max<Clock::duration>(time_window / TIME_BUCKETS_COUNT, Clock::duration(1)))
+    , time_buckets_(TIME_BUCKETS_COUNT)
+{
+}
+
+void RequestStatistics::AddRequest(size_t result_count, Clock::duration latency) {
+    AddRequest(Clock::now(), result_count, latency);
+}
+
+void RequestStatistics::AddRequest(Clock::time_point time, size_t result_count, Clock::duration latency) {
+    const uint64_t meta = PackMeta(result_count, latency);
+    Slot& slot = slots_[next_slot_.fetch_add(1, std::memory_order_relaxed) % slots_.size()];
+    // Другой писатель, попавший в тот же слот после полного оборота буфера, ждёт.
+    // Счётчики обновляются, пока слот занят: вытесняющий писатель вычитает
+    // запись только после того, как её писатель её учёл
+    const uint64_t sequence = LockSequence(slot.sequence);
+    const uint64_t evicted = slot.meta.load(std::memory_order_relaxed);
+    slot.meta.store(meta, std::memory_order_relaxed);
+    slot.time.store(time.time_since_epoch().count(), std::memory_order_relaxed);
+    Account(meta, evicted);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    AddToTimeWindow(time, result_count == 0);
+}
+
+size_t RequestStatistics::GetCapacity() const {
+    return slots_.size();
+}
+
+uint64_t RequestStatistics::GetTotalRequests() const {
+    return next_slot_.load(std::memory_order_relaxed);
+}
+
+int RequestStatistics::GetRequestCount() const {
+    return request_count_.load(std::memory_order_relaxed);
+}
+
+int RequestStatistics::GetNoResultRequests() const {
+    return no_result_requests_.load(std::memory_order_relaxed);
+}
+
+RequestStatistics::LatencyHistogram RequestStatistics::GetLatencyHistogram() const {
+    LatencyHistogram result;
+    for (size_t i = 0; i < LATENCY_BUCKETS_COUNT; ++i) {
+        result[i] = latency_histogram_[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+std::chrono::microseconds RequestStatistics::GetLatencyPercentile(double percentile) const {
+    const LatencyHistogram histogram = GetLatencyHistogram();
+    uint64_t total = 0;
+    for (uint64_t count : histogram) {
+        total += count;
+    }
+    if (total == 0) {
+        return std::chrono::microseconds(0);
+    }
+    const double clamped = std::clamp(percentile, 0.0, 100.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped / 100.0 * total + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS_COUNT; ++i) {
+        seen += histogram[i];
+        if (seen >= rank) {
+            return std::chrono::microseconds((1ll << (i + 1)) - 1);
+        }
+    }
+    return std::chrono::microseconds(META_LATENCY_MASK);
+}
+
+int RequestStatistics::GetRequestCountInTimeWindow() const {
+    return GetRequestCountInTimeWindow(Clock::now());
+}
+
+int RequestStatistics::GetNoResultRequestsInTimeWindow() const {
+    return GetNoResultRequestsInTimeWindow(Clock::now());
+}
+
+int RequestStatistics::GetRequestCountInTimeWindow(Clock::time_point now) const {
+    return SumTimeWindow(now, [](const TimeBucket& bucket) {
+        return bucket.request_count.load(std::memory_order_relaxed);
+    });
+}
+
+int RequestStatistics::GetNoResultRequestsInTimeWindow(Clock::time_point now) const {
+    return SumTimeWindow(now, [](const TimeBucket& bucket) {
+        return bucket.no_result_count.load(std::memory_order_relaxed);
+    });
+}
+
+std::vector<RequestStatistics::Record> RequestStatistics::GetLastRecords() const {
+    std::vector<Record> result;
+    const uint64_t next = next_slot_.load(std::memory_order_acquire);
+    const uint64_t count = std::min<uint64_t>(next, slots_.size());
+    result.reserve(count);
+    for (uint64_t index = next - count; index < next; ++index) {
+        const Slot& slot = slots_[index % slots_.size()];
+        uint64_t meta = 0;
+        Clock::rep time = 0;
+        uint64_t sequence_before = 0;
+        uint64_t sequence_after = 0;
+        do {
+            sequence_before = slot.sequence.load(std::memory_order_acquire);
+            meta = slot.meta.load(std::memory_order_relaxed);
+            time = slot.time.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            sequence_after = slot.sequence.load(std::memory_order_relaxed);
+        } while ((sequence_before & 1) || sequence_before != sequence_after);
+        if (!(meta & META_FILLED_BIT)) {
+            continue;
+        }
+        Record record = UnpackMeta(meta);
+        record.time = Clock::time_point(Clock::duration(time));
+        result.push_back(record);
+    }
+    return result;
+}
+
+uint64_t RequestStatistics::PackMeta(size_t result_count, Clock::duration latency) {
+    using namespace std::chrono;
+    const uint64_t latency_us = std::clamp<int64_t>(duration_cast<microseconds>(latency).count(), 0, META_LATENCY_MASK);
+    uint64_t meta = META_FILLED_BIT | latency_us;
+    meta |= std::min<uint64_t>(result_count, META_RESULT_COUNT_MASK) << META_RESULT_COUNT_SHIFT;
+    if (result_count == 0) {
+        meta |= META_EMPTY_BIT;
+    }
+    return meta;
+}
+
+RequestStatistics::Record RequestStatistics::UnpackMeta(uint64_t meta) {
+    Record record;
+    record.result_count = static_cast<uint32_t>((meta >> META_RESULT_COUNT_SHIFT) & META_RESULT_COUNT_MASK);
+    record.latency = std::chrono::microseconds(meta & META_LATENCY_MASK);
+    record.is_empty = (meta & META_EMPTY_BIT) != 0;
+    return record;
+}
+
+size_t RequestStatistics::GetLatencyBucket(uint64_t latency_us) {
+    size_t bucket = 0;
+    for (uint64_t value = latency_us + 1; value > 1 && bucket + 1 < LATENCY_BUCKETS_COUNT; value >>= 1) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+uint64_t RequestStatistics::LockSequence(std::atomic<uint64_t>& sequence) {
+    uint64_t value = sequence.load(std::memory_order_relaxed);
+    do {
+        while (value & 1) {
+            value = sequence.load(std::memory_order_relaxed);
+        }
+    } while (!sequence.compare_exchange_weak(value, value + 1, std::memory_order_acquire, std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+    return value;
+}
+
+void RequestStatistics::Account(uint64_t meta, uint64_t evicted) {
+    const bool is_evicted = (evicted & META_FILLED_BIT) != 0;
+    // Вытеснение не меняет число запросов в окне, поэтому оно не превышает ёмкость
+    if (!is_evicted) {
+        request_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    const int no_result_delta = ((meta & META_EMPTY_BIT) ? 1 : 0) - ((is_evicted && (evicted & META_EMPTY_BIT)) ? 1 : 0);
+    if (no_result_delta != 0) {
+        no_result_requests_.fetch_add(no_result_delta, std::memory_order_relaxed);
+    }
+    // Гистограмма меняется двумя операциями, поэтому во время записей она
+    // приблизительна: сумма может ненадолго превысить ёмкость. Вычитание идёт
+    // после учёта вытесняемой записи, и корзина не становится отрицательной
+    const size_t bucket = GetLatencyBucket(meta & META_LATENCY_MASK);
+    const size_t evicted_bucket = is_evicted ? GetLatencyBucket(evicted & META_LATENCY_MASK) : LATENCY_BUCKETS_COUNT;
+    if (bucket != evicted_bucket) {
+        latency_histogram_[bucket].fetch_add(1, std::memory_order_relaxed);
+        if (is_evicted) {
+            latency_histogram_[evicted_bucket].fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void RequestStatistics::AddToTimeWindow(Clock::time_point time, bool is_empty) {
+    const uint64_t tick = time.time_since_epoch() / time_bucket_duration_ + 1;
+    TimeBucket& bucket = time_buckets_[tick % TIME_BUCKETS_COUNT];
+    const uint64_t sequence = LockSequence(bucket.sequence);
+    if (bucket.tick.load(std::memory_order_relaxed) != tick) {
+        bucket.tick.store(tick, std::memory_order_relaxed);
+        bucket.request_count.store(0, std::memory_order_relaxed);
+        bucket.no_result_count.store(0, std::memory_order_relaxed);
+    }
+    bucket.request_count.store(bucket.request_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (is_empty) {
+        bucket.no_result_count.store(bucket.no_result_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    bucket.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+template <typename Getter>
+int RequestStatistics::SumTimeWindow(Clock::time_point now, Getter getter) const {
+    const uint64_t now_tick = now.time_since_epoch() / time_bucket_duration_ + 1;
+    uint64_t result = 0;
+    for (const TimeBucket& bucket : time_buckets_) {
+        uint64_t tick = 0;
+        uint64_t value = 0;
+        uint64_t sequence_before = 0;
+        uint64_t sequence_after = 0;
+        do {
+            sequence_before = bucket.sequence.load(std::memory_order_acquire);
+            tick = bucket.tick.load(std::memory_order_relaxed);
+            value = getter(bucket);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            sequence_after = bucket.sequence.load(std::memory_order_relaxed);
+        } while ((sequence_before & 1) || sequence_before != sequence_after);
+        if (tick != 0 && tick <= now_tick && now_tick - tick < TIME_BUCKETS_COUNT) {
+            result += value;
+        }
+    }
+    return static_cast<int>(std::min<uint64_t>(result, std::numeric_limits<int>::max()));
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Статистика последних запросов и окна по времени; методы можно вызывать из любых потоков
+class RequestStatistics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t LATENCY_BUCKETS_COUNT = 32;
+    static constexpr size_t TIME_BUCKETS_COUNT = 60;
+
+    struct Record {
+        Clock::time_point time;
+        uint32_t result_count = 0;
+        std::chrono::microseconds latency{0};
+        bool is_empty = true;
+    };
+
+    // Корзина i содержит запросы с задержкой в микросекундах из [2^i - 1, 2^(i+1) - 1)
+    using LatencyHistogram = std::array<uint64_t, LATENCY_BUCKETS_COUNT>;
+
+    explicit RequestStatistics(size_t capacity = 1440, Clock::duration time_window = std::chrono::hours(24));
+
+    void AddRequest(size_t result_count, Clock::duration latency);
+    void AddRequest(Clock::time_point time, size_t result_count, Clock::duration latency);
+
+    size_t GetCapacity() const;
+    uint64_t GetTotalRequests() const;
+
+    int GetRequestCount() const;
+    int GetNoResultRequests() const;
+    // Во время одновременных записей сумма может ненадолго превысить ёмкость
+    LatencyHistogram GetLatencyHistogram() const;
+    std::chrono::microseconds GetLatencyPercentile(double percentile) const;
+
+    int GetRequestCountInTimeWindow() const;
+    int GetNoResultRequestsInTimeWindow() const;
+    int GetRequestCountInTimeWindow(Clock::time_point now) const;
+    int GetNoResultRequestsInTimeWindow(Clock::time_point now) const;
+
+    std::vector<Record> GetLastRecords() const;
+
+private:
+    // Запись кольцевого буфера. meta упаковывает флаг заполненности,
+    // флаг пустого ответа, число результатов и задержку. meta и time
+    // изменяются вместе под номером версии sequence: нечётный номер означает,
+    // что слот занят писателем, а читатель повторяет чтение, если номер
+    // изменился, и поэтому не смешивает поля разных записей.
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> meta{0};
+        std::atomic<Clock::rep> time{0};
+    };
+
+    // Корзина окна по времени: номер интервала (0 — корзина пуста) и счётчики
+    // меняются вместе под номером версии sequence, как поля Slot
+    struct TimeBucket {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> tick{0};
+        std::atomic<uint64_t> request_count{0};
+        std::atomic<uint64_t> no_result_count{0};
+    };
+
+    std::vector<Slot> slots_;
+    std::atomic<uint64_t> next_slot_{0};
+
+    std::atomic<int> request_count_{0};
+    std::atomic<int> no_result_requests_{0};
+    std::array<std::atomic<uint64_t>, LATENCY_BUCKETS_COUNT> latency_histogram_{};
+
+    const Clock::duration time_bucket_duration_;
+    std::vector<TimeBucket> time_buckets_;
+
+    static uint64_t PackMeta(size_t result_count, Clock::duration latency);
+    static Record UnpackMeta(uint64_t meta);
+    static size_t GetLatencyBucket(uint64_t latency_us);
+
+    // Занимает версию для записи; возвращает чётный номер, который была до неё
+    static uint64_t LockSequence(std::atomic<uint64_t>& sequence);
+    // Учитывает запись meta, вытеснившую из буфера запись evicted
+    void Account(uint64_t meta, uint64_t evicted);
+    void AddToTimeWindow(Clock::time_point time, bool is_empty);
+
+    template <typename Getter>
+    int SumTimeWindow(Clock::time_point now, Getter getter) const;
+};
@@ -0,0 +1,380 @@
+#include "rpc.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace rpc {
+
+namespace {
+
+[[noreturn]] void ThrowSystemError(const std::string& what) {
+    throw std::runtime_error(what + ": "s + std::strerror(errno));
+}
+
+bool IsUnixAddress(const std::string& address) {
+    return address.rfind("unix:"s, 0) == 0;
+}
+
+sockaddr_un MakeUnixAddress(const std::string& address) {
+    const std::string path = address.substr(5);
+    sockaddr_un result{};
+    if (path.empty() || path.size() >= sizeof(result.sun_path)) {
+        throw std::invalid_argument("Некорректный путь к сокету: "s + address);
+    }
+    result.sun_family = AF_UNIX;
+    std::memcpy(result.sun_path, path.data(), path.size());
+    return result;
+}
+
+struct AddressInfoDeleter {
+    void operator()(addrinfo* info) const {
+        freeaddrinfo(info);
+    }
+};
+
+std::unique_ptr<addrinfo, AddressInfoDeleter> ResolveTcpAddress(const std::string& address, bool is_passive) {
+    const size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        throw std::invalid_argument("Ожидается адрес вида host:port или unix:/path: "s + address);
+    }
+    const std::string host = address.substr(0, colon);
+    const std::string port = address.substr(colon + 1);
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = is_passive ? AI_PASSIVE : 0;
+    addrinfo* info = nullptr;
+    const int error = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &info);
+    if (error != 0) {
+        throw std::runtime_error("Не удалось разрешить адрес "s + address + ": "s + gai_strerror(error));
+    }
+    return std::unique_ptr<addrinfo, AddressInfoDeleter>(info);
+}
+
+void SetNoDelay(int fd) {
+    const int flag = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+}
+
+MessageWriter::MessageWriter(MessageType type) {
+    buffer_.assign(HEADER_SIZE, '\0');
+    buffer_[4] = static_cast<char>(type);
+}
+
+std::string MessageWriter::Finish() {
+    const size_t body_size = buffer_.size() - HEADER_SIZE;
+    if (body_size > MAX_BODY_SIZE) {
+        throw std::length_error("Слишком большое сообщение"s);
+    }
+    const uint32_t size = static_cast<uint32_t>(body_size);
+    for (size_t i = 0; i < 4; ++i) {
+        buffer_[i] = static_cast<char>((size >> (8 * i)) & 0xFF);
+    }
+    return std::move(buffer_);
+}
+
+Socket::Socket(int fd)
+    : fd_(fd)
+{
+}
+
+Socket::Socket(Socket&& other) noexcept
+    : fd_(other.fd_)
+{
+    other.fd_ = -1;
+}
+
+Socket& Socket::operator=(Socket&& other) noexcept {
+    if (this != &other) {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+        fd_ = other.fd_;
+        other.fd_ = -1;
+    }
+    return *this;
+}
+
+Socket::~Socket() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+Socket Socket::Connect(const std::string& address, std::chrono::milliseconds timeout) {
+    if (IsUnixAddress(address)) {
+        const sockaddr_un unix_address = MakeUnixAddress(address);
+        Socket socket(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+        if (!socket.IsValid()) {
+            ThrowSystemError("socket"s);
+        }
+        socket.SetTimeout(timeout);
+        if (connect(socket.fd_, reinterpret_cast<const sockaddr*>(&unix_address), sizeof(unix_address)) != 0) {
+            ThrowSystemError("Не удалось подключиться к "s + address);
+        }
+        return socket;
+    }
+    const auto info = ResolveTcpAddress(address, false);
+    for (const addrinfo* candidate = info.get(); candidate != nullptr; candidate = candidate->ai_next) {
+        Socket socket(::socket(candidate->ai_family, candidate->ai_socktype | SOCK_CLOEXEC, candidate->ai_protocol));
+        if (!socket.IsValid()) {
+            continue;
+        }
+        socket.SetTimeout(timeout);
+        if (connect(socket.fd_, candidate->ai_addr, candidate->ai_addrlen) == 0) {
+            SetNoDelay(socket.fd_);
+            return socket;
+        }
+    }
+    ThrowSystemError("Не удалось подключиться к "s + address);
+}
+
+void Socket::SetTimeout(std::chrono::milliseconds timeout) {
+    timeout_ms_ = static_cast<int>(timeout.count());
+    timeval value{};
+    value.tv_sec = timeout.count() / 1000;
+    value.tv_usec = (timeout.count() % 1000) * 1000;
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value));
+    setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &value, sizeof(value));
+}
+
+void Socket::SetNonBlocking() {
+    const int flags = fcntl(fd_, F_GETFL);
+    if (flags < 0 || fcntl(fd_, F_SETFL, flags | O_NONBLOCK) != 0) {
+        ThrowSystemError("fcntl"s);
+    }
+}
+
+void Socket::Send(std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t sent = send(fd_, data.data(), data.size(), MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                pollfd poll_fd{fd_, POLLOUT, 0};
+                const int ready = poll(&poll_fd, 1, timeout_ms_);
+                if (ready == 0) {
+                    throw std::runtime_error("Истекло время отправки сообщения"s);
+                }
+                if (ready < 0 && errno != EINTR) {
+                    ThrowSystemError("poll"s);
+                }
+                continue;
+            }
+            ThrowSystemError("send"s);
+        }
+        data.remove_prefix(sent);
+    }
+}
+
+bool Socket::ReceiveAvailable(std::string& buffer) {
+    constexpr size_t CHUNK_SIZE = 64 * 1024;
+    while (true) {
+        const size_t old_size = buffer.size();
+        buffer.resize(old_size + CHUNK_SIZE);
+        const ssize_t result = recv(fd_, buffer.data() + old_size, CHUNK_SIZE, 0);
+        buffer.resize(old_size + std::max<ssize_t>(result, 0));
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            ThrowSystemError("recv"s);
+        }
+        if (result == 0) {
+            return false;
+        }
+        if (static_cast<size_t>(result) < CHUNK_SIZE) {
+            return true;
+        }
+    }
+}
+
+int Socket::GetFd() const {
+    return fd_;
+}
+
+bool Socket::IsValid() const {
+    return fd_ >= 0;
+}
+
+bool MessageReceiver::ReadAvailable(Socket& socket) {
+    const bool is_open = socket.ReceiveAvailable(buffer_);
+    CheckHeader();
+    return is_open;
+}
+
+std::optional<Message> MessageReceiver::PopMessage() {
+    if (buffer_.size() < HEADER_SIZE) {
+        return std::nullopt;
+    }
+    const uint32_t body_size = DecodeUint32(buffer_);
+    if (buffer_.size() < HEADER_SIZE + body_size) {
+        return std::nullopt;
+    }
+    Message message{static_cast<MessageType>(buffer_[4]), buffer_.substr(HEADER_SIZE, body_size)};
+    buffer_.erase(0, HEADER_SIZE + body_size);
+    CheckHeader();
+    return message;
+}
+
+bool MessageReceiver::IsEmpty() const {
+    return buffer_.empty();
+}
+
+void MessageReceiver::CheckHeader() const {
+    if (buffer_.size() >= HEADER_SIZE && DecodeUint32(buffer_) > MAX_BODY_SIZE) {
+        throw std::runtime_error("Слишком большое сообщение"s);
+    }
+}
+
+Listener::Listener(const std::string& address) {
+    if (IsUnixAddress(address)) {
+        const sockaddr_un unix_address = MakeUnixAddress(address);
+        socket_ = Socket(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0));
+        if (!socket_.IsValid()) {
+            ThrowSystemError("socket"s);
+        }
+        unix_path_ = address.substr(5);
+        unlink(unix_path_.c_str());
+        if (bind(socket_.GetFd(), reinterpret_cast<const sockaddr*>(&unix_address), sizeof(unix_address)) != 0) {
+            ThrowSystemError("Не удалось открыть "s + address);
+        }
+    } else {
+        const auto info = ResolveTcpAddress(address, true);
+        socket_ = Socket(::socket(info->ai_family, info->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, info->ai_protocol));
+        if (!socket_.IsValid()) {
+            ThrowSystemError("socket"s);
+        }
+        const int flag = 1;
+        setsockopt(socket_.GetFd(), SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+        if (bind(socket_.GetFd(), info->ai_addr, info->ai_addrlen) != 0) {
+            ThrowSystemError("Не удалось открыть "s + address);
+        }
+    }
+    if (listen(socket_.GetFd(), SOMAXCONN) != 0) {
+        ThrowSystemError("listen"s);
+    }
+}
+
+Socket Listener::Accept() {
+    while (true) {
+        const int fd = accept4(socket_.GetFd(), nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (fd >= 0) {
+            if (unix_path_.empty()) {
+                SetNoDelay(fd);
+            }
+            return Socket(fd);
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return Socket();
+        }
+        if (errno != EINTR && errno != ECONNABORTED) {
+            ThrowSystemError("accept"s);
+        }
+    }
+}
+
+int Listener::GetFd() const {
+    return socket_.GetFd();
+}
+
+void WriteStatistics(BinaryWriter& writer, const CorpusStatistics& statistics) {
+    writer.WriteInt32(statistics.document_count).WriteUint64(static_cast<uint64_t>(statistics.total_document_length));
+    writer.WriteUint32(static_cast<uint32_t>(statistics.document_freqs.size()));
+    for (const auto& [word, document_freq] : statistics.document_freqs) {
+        writer.WriteString(word).WriteInt32(document_freq);
+    }
+}
+
+CorpusStatistics ReadStatistics(BinaryReader& reader) {
+    CorpusStatistics statistics;
+    statistics.document_count = reader.ReadInt32();
+    statistics.total_document_length = static_cast<int64_t>(reader.ReadUint64());
+    // Слово — строка с длиной и частота
+    const uint32_t word_count = reader.ReadCount(2 * sizeof(uint32_t));
+    for (uint32_t i = 0; i < word_count; ++i) {
+        const std::string_view word = reader.ReadString();
+        statistics.document_freqs.emplace(word, reader.ReadInt32());
+    }
+    return statistics;
+}
+
+void WriteFilter(BinaryWriter& writer, const DocumentFilter& filter) {
+    writer.WriteUint32(filter.status_mask).WriteInt32(filter.min_rating).WriteInt32(filter.max_rating);
+}
+
+DocumentFilter ReadFilter(BinaryReader& reader) {
+    DocumentFilter filter;
+    filter.status_mask = reader.ReadUint32();
+    filter.min_rating = reader.ReadInt32();
+    filter.max_rating = reader.ReadInt32();
+    return filter;
+}
+
+void WriteDocuments(BinaryWriter& writer, const std::vector<Document>& documents) {
+    writer.WriteUint32(static_cast<uint32_t>(documents.size()));
+    for (const Document& document : documents) {
+        writer.WriteInt32(document.id).WriteDouble(document.relevance).WriteInt32(document.rating);
+    }
+}
+
+std::vector<Document> ReadDocuments(BinaryReader& reader) {
+    // Документ — id, релевантность и рейтинг
+    const uint32_t count = reader.ReadCount(2 * sizeof(int32_t) + sizeof(double));
+    std::vector<Document> documents;
+    documents.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const int id = reader.ReadInt32();
+        const double relevance = reader.ReadDouble();
+        documents.emplace_back(id, relevance, reader.ReadInt32());
+    }
+    return documents;
+}
+
+std::string MakeErrorResponse(ErrorKind kind, std::string_view what) {
+    MessageWriter writer(MessageType::ERROR_RESPONSE);
+    writer.WriteUint32(static_cast<uint32_t>(kind)).WriteString(what);
+    return writer.Finish();
+}
+
+void CheckResponse(const Message& response, MessageType expected_type) {
+    if (response.type == MessageType::ERROR_RESPONSE) {
+        MessageReader reader(response.body);
+        const auto kind = static_cast<ErrorKind>(reader.ReadUint32());
+        const std::string what(reader.ReadString());
+        switch (kind) {
+            case ErrorKind::INVALID_ARGUMENT: throw std::invalid_argument(what);
+            case ErrorKind::OUT_OF_RANGE: throw std::out_of_range(what);
+            case ErrorKind::OTHER: break;
+        }
+        throw std::runtime_error(what);
+    }
+    if (response.type != expected_type) {
+        throw std::runtime_error("Неожиданный тип ответа"s);
+    }
+}
+
+}
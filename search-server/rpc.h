@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "binary_io.h"
+#include "document.h"
+#include "document_filter.h"
+#include "corpus_statistics.h"
+
+// Протокол агрегатора и частей: заголовок (длина тела uint32, тип uint8) и тело BinaryWriter.
+// Адрес — "unix:/path" или "host:port"
+namespace rpc {
+
+enum class MessageType : uint8_t {
+    STATISTICS_REQUEST = 1,
+    STATISTICS_RESPONSE,
+    SEARCH_REQUEST,
+    SEARCH_RESPONSE,
+    MATCH_REQUEST,
+    MATCH_RESPONSE,
+    ERROR_RESPONSE,
+};
+
+// Вид исключения, которое ответ ERROR_RESPONSE передаёт вызывающей стороне
+enum class ErrorKind : uint8_t {
+    INVALID_ARGUMENT,
+    OUT_OF_RANGE,
+    OTHER,
+};
+
+constexpr size_t HEADER_SIZE = 5;
+constexpr uint32_t MAX_BODY_SIZE = 64u << 20;
+
+struct Message {
+    MessageType type;
+    std::string body;
+};
+
+// Сообщение: заголовок заполняется в Finish
+class MessageWriter : public BinaryWriter {
+public:
+    explicit MessageWriter(MessageType type);
+
+    // Возвращает сообщение вместе с заголовком, готовое к отправке
+    std::string Finish();
+};
+
+using MessageReader = BinaryReader;
+
+// Сокет, владеющий дескриптором
+class Socket {
+public:
+    Socket() = default;
+    explicit Socket(int fd);
+    Socket(Socket&& other) noexcept;
+    Socket& operator=(Socket&& other) noexcept;
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+    ~Socket();
+
+    static Socket Connect(const std::string& address, std::chrono::milliseconds timeout);
+
+    // Ограничивает время подключения и Send
+    void SetTimeout(std::chrono::milliseconds timeout);
+    void SetNonBlocking();
+
+    // На неблокирующем сокете ждёт места в буфере отправки через poll
+    void Send(std::string_view data);
+    // Дописывает в buffer данные, уже пришедшие на неблокирующий сокет.
+    // false, если соединение закрыто собеседником
+    bool ReceiveAvailable(std::string& buffer);
+
+    int GetFd() const;
+    bool IsValid() const;
+
+private:
+    int fd_ = -1;
+    // Отрицательное значение — без ограничения
+    int timeout_ms_ = -1;
+};
+
+// Собирает сообщения из данных неблокирующего сокета по мере их прихода
+class MessageReceiver {
+public:
+    // Читает всё, что уже пришло. false, если соединение закрыто собеседником
+    bool ReadAvailable(Socket& socket);
+    // Очередное полностью полученное сообщение
+    std::optional<Message> PopMessage();
+    // Нет прочитанных, но не извлечённых данных
+    bool IsEmpty() const;
+
+private:
+    std::string buffer_;
+
+    void CheckHeader() const;
+};
+
+class Listener {
+public:
+    explicit Listener(const std::string& address);
+
+    // Listener не блокируется: пустой Socket, если ожидающих соединений нет.
+    // Принятый сокет неблокирующий
+    Socket Accept();
+    int GetFd() const;
+
+private:
+    Socket socket_;
+    std::string unix_path_;
+};
+
+// Кодирование прикладных данных
+void WriteStatistics(BinaryWriter& writer, const CorpusStatistics& statistics);
+CorpusStatistics ReadStatistics(BinaryReader& reader);
+
+void WriteFilter(BinaryWriter& writer, const DocumentFilter& filter);
+DocumentFilter ReadFilter(BinaryReader& reader);
+
+void WriteDocuments(BinaryWriter& writer, const std::vector<Document>& documents);
+std::vector<Document> ReadDocuments(BinaryReader& reader);
+
+std::string MakeErrorResponse(ErrorKind kind, std::string_view what);
+// Бросает исключение, переданное ответом ERROR_RESPONSE, или std::runtime_error,
+// если тип ответа не совпадает с ожидаемым
+void CheckResponse(const Message& response, MessageType expected_type);
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+
+enum class RankingFunction {
+    TF_IDF,
+    BM25,
+};
+
+// Политики оценки релевантности — параметры шаблонов поиска SearchServer.
+// ComputeUpperBound — наибольший вклад слова, по нему отсекаются документы при поиске по вкладам
+class TfIdfScoring {
+public:
+    static constexpr bool USES_DOCUMENT_LENGTH = false;
+
+    explicit TfIdfScoring(double /*average_document_length*/) {
+    }
+
+    static double ComputeInverseDocumentFreq(int document_count, int document_freq) {
+        return std::log(document_count * 1.0 / document_freq);
+    }
+
+    double ComputeScore(double term_freq, int /*document_length*/, double inverse_document_freq) const {
+        return term_freq * inverse_document_freq;
+    }
+
+    double ComputeUpperBound(double term_freq, double inverse_document_freq) const {
+        return term_freq * inverse_document_freq;
+    }
+};
+
+// Okapi BM25 с нормализацией по длине документа
+class Bm25Scoring {
+public:
+    // Насыщение вклада частоты слова
+    static constexpr double K1 = 1.2;
+    // Доля нормализации по длине документа
+    static constexpr double B = 0.75;
+    static constexpr bool USES_DOCUMENT_LENGTH = true;
+
+    explicit Bm25Scoring(double average_document_length)
+        : length_factor_(K1 * B / std::max(average_document_length, 1.0)) {
+    }
+
+    // Вариант IDF, не принимающий отрицательных значений для частых слов
+    static double ComputeInverseDocumentFreq(int document_count, int document_freq) {
+        return std::log(1.0 + (document_count - document_freq + 0.5) / (document_freq + 0.5));
+    }
+
+    double ComputeScore(double term_freq, int document_length, double inverse_document_freq) const {
+        const double term_count = term_freq * document_length;
+        return inverse_document_freq * term_count * (K1 + 1.0)
+            / (term_count + K1 * (1.0 - B) + length_factor_ * document_length);
+    }
+
+    // При постоянной доле слова вклад растёт с длиной документа и не превышает предела
+    // term_freq * (K1 + 1) / (term_freq + K1 * B / средняя длина)
+    double ComputeUpperBound(double term_freq, double inverse_document_freq) const {
+        return inverse_document_freq * term_freq * (K1 + 1.0) / (term_freq + length_factor_);
+    }
+
+private:
+    // K1 * B / средняя длина документа
+    double length_factor_;
+};
+
+using Scoring = std::variant<TfIdfScoring, Bm25Scoring>;
+
+inline Scoring MakeScoring(RankingFunction ranking_function, double average_document_length) {
+    if (ranking_function == RankingFunction::BM25) {
+        return Bm25Scoring(average_document_length);
+    }
+    return TfIdfScoring(average_document_length);
+}
+
+// "tf-idf" или "bm25", для аргументов командной строки
+inline RankingFunction ParseRankingFunction(std::string_view name) {
+    using namespace std::string_literals;
+    if (name == "tf-idf") {
+        return RankingFunction::TF_IDF;
+    }
+    if (name == "bm25") {
+        return RankingFunction::BM25;
+    }
+    throw std::invalid_argument("Неизвестная функция ранжирования: "s + std::string(name));
+}
@@ -0,0 +1,272 @@
+#include "search_aggregator.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+
+#include <poll.h>
+
+#include "search_server.h"
+
+using namespace std::string_literals;
+
+SearchAggregator::SearchAggregator(const std::vector<std::vector<std::string>>& shard_addresses, AggregatorOptions options)
+    : options_(options)
+{
+    if (shard_addresses.empty()) {
+        throw std::invalid_argument("Не задано ни одной части индекса"s);
+    }
+    for (const auto& replica_addresses : shard_addresses) {
+        if (replica_addresses.empty()) {
+            throw std::invalid_argument("У части индекса нет ни одной реплики"s);
+        }
+        auto shard = std::make_unique<Shard>();
+        for (const std::string& address : replica_addresses) {
+            shard->replicas.push_back(std::make_unique<Replica>());
+            shard->replicas.back()->address = address;
+        }
+        shards_.push_back(std::move(shard));
+    }
+}
+
+std::vector<Document> SearchAggregator::FindTopDocuments(std::string_view raw_query, const DocumentFilter& filter) const {
+    const CorpusStatistics statistics = GetCorpusStatistics(raw_query);
+    rpc::MessageWriter writer(rpc::MessageType::SEARCH_REQUEST);
+    writer.WriteString(raw_query);
+    rpc::WriteStatistics(writer, statistics);
+    rpc::WriteFilter(writer, filter);
+    std::vector<Document> documents;
+    for (const rpc::Message& response : Broadcast(writer.Finish())) {
+        rpc::CheckResponse(response, rpc::MessageType::SEARCH_RESPONSE);
+        rpc::MessageReader reader(response.body);
+        for (const Document& document : rpc::ReadDocuments(reader)) {
+            documents.push_back(document);
+        }
+    }
+    // Каждая часть вернула свои лучшие документы, среди них есть и лучшие общие
+    const size_t result_count = std::min<size_t>(documents.size(), MAX_RESULT_DOCUMENT_COUNT);
+    std::partial_sort(documents.begin(), documents.begin() + result_count, documents.end(), SearchServer::IsRankedBefore);
+    documents.resize(result_count);
+    return documents;
+}
+
+std::vector<Document> SearchAggregator::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(raw_query, DocumentFilter(status));
+}
+
+std::vector<Document> SearchAggregator::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+CorpusStatistics SearchAggregator::GetCorpusStatistics(std::string_view raw_query) const {
+    rpc::MessageWriter writer(rpc::MessageType::STATISTICS_REQUEST);
+    writer.WriteString(raw_query);
+    CorpusStatistics statistics;
+    for (const rpc::Message& response : Broadcast(writer.Finish())) {
+        rpc::CheckResponse(response, rpc::MessageType::STATISTICS_RESPONSE);
+        rpc::MessageReader reader(response.body);
+        statistics.Merge(rpc::ReadStatistics(reader));
+    }
+    return statistics;
+}
+
+SearchAggregator::MatchedDocument SearchAggregator::MatchDocument(std::string_view raw_query, int document_id) const {
+    if (document_id < 0) {
+        throw std::out_of_range("document_id не существует"s);
+    }
+    rpc::MessageWriter writer(rpc::MessageType::MATCH_REQUEST);
+    writer.WriteString(raw_query).WriteInt32(document_id);
+    const rpc::Message response = Call({document_id % shards_.size()}, writer.Finish()).front();
+    rpc::CheckResponse(response, rpc::MessageType::MATCH_RESPONSE);
+    rpc::MessageReader reader(response.body);
+    // Каждое слово занимает хотя бы длину строки
+    std::vector<std::string> words(reader.ReadCount(sizeof(uint32_t)));
+    for (std::string& word : words) {
+        word = reader.ReadString();
+    }
+    const uint32_t status = reader.ReadUint32();
+    if (status >= DOCUMENT_STATUSES_COUNT) {
+        throw std::runtime_error("Некорректный статус документа в ответе"s);
+    }
+    return {std::move(words), static_cast<DocumentStatus>(status)};
+}
+
+size_t SearchAggregator::GetShardCount() const {
+    return shards_.size();
+}
+
+uint64_t SearchAggregator::GetHedgedRequestCount() const {
+    return hedged_request_count_.load(std::memory_order_relaxed);
+}
+
+rpc::Socket SearchAggregator::AcquireSocket(Replica& replica) const {
+    {
+        std::lock_guard guard(replica.mutex);
+        if (!replica.idle_sockets.empty()) {
+            rpc::Socket socket = std::move(replica.idle_sockets.back());
+            replica.idle_sockets.pop_back();
+            return socket;
+        }
+    }
+    rpc::Socket socket = rpc::Socket::Connect(replica.address, options_.timeout);
+    socket.SetNonBlocking();
+    return socket;
+}
+
+void SearchAggregator::ReleaseSocket(Replica& replica, rpc::Socket socket) const {
+    std::lock_guard guard(replica.mutex);
+    replica.idle_sockets.push_back(std::move(socket));
+}
+
+std::vector<rpc::Message> SearchAggregator::Broadcast(const std::string& request) const {
+    std::vector<size_t> shard_indexes(shards_.size());
+    std::iota(shard_indexes.begin(), shard_indexes.end(), 0);
+    return Call(shard_indexes, request);
+}
+
+std::vector<rpc::Message> SearchAggregator::Call(const std::vector<size_t>& shard_indexes, const std::string& request) const {
+    using Clock = std::chrono::steady_clock;
+
+    struct Attempt {
+        size_t call;
+        Replica* replica;
+        rpc::Socket socket;
+        rpc::MessageReceiver receiver;
+    };
+    struct PendingCall {
+        Shard* shard = nullptr;
+        size_t attempt_count = 0;
+        size_t active_count = 0;
+        std::optional<rpc::Message> response;
+        std::string last_error;
+    };
+
+    std::vector<PendingCall> calls;
+    calls.reserve(shard_indexes.size());
+    for (const size_t shard_index : shard_indexes) {
+        calls.emplace_back().shard = shards_.at(shard_index).get();
+    }
+    std::vector<Attempt> attempts;
+    size_t done_count = 0;
+
+    // Отправляет запрос очередной реплике части; при ошибке пробует следующую.
+    // Каждой части даётся на одну попытку больше, чем у неё реплик, чтобы запрос
+    // к единственной реплике тоже можно было повторить.
+    const auto start_attempt = [&](size_t call_index) {
+        PendingCall& call = calls[call_index];
+        const size_t max_attempt_count = call.shard->replicas.size() + 1;
+        while (call.attempt_count < max_attempt_count) {
+            ++call.attempt_count;
+            Replica& replica = *call.shard->replicas[call.shard->next_replica++ % call.shard->replicas.size()];
+            try {
+                rpc::Socket socket = AcquireSocket(replica);
+                socket.Send(request);
+                attempts.push_back({call_index, &replica, std::move(socket), {}});
+                ++call.active_count;
+                return;
+            } catch (const std::exception& e) {
+                call.last_error = e.what();
+            }
+        }
+    };
+
+    const Clock::time_point start_time = Clock::now();
+    const Clock::time_point deadline = start_time + options_.timeout;
+    const Clock::time_point hedge_time = start_time + options_.hedge_delay;
+    bool is_hedged = false;
+    for (size_t i = 0; i < calls.size(); ++i) {
+        start_attempt(i);
+    }
+
+    std::vector<pollfd> poll_fds;
+    while (done_count < calls.size()) {
+        for (const PendingCall& call : calls) {
+            if (!call.response && call.active_count == 0) {
+                throw std::runtime_error("Часть индекса недоступна: "s + call.last_error);
+            }
+        }
+        const Clock::time_point now = Clock::now();
+        if (now >= deadline) {
+            throw std::runtime_error("Истекло время ожидания ответа части индекса"s);
+        }
+        if (!is_hedged && now >= hedge_time) {
+            is_hedged = true;
+            for (size_t i = 0; i < calls.size(); ++i) {
+                if (!calls[i].response && calls[i].active_count == 1) {
+                    start_attempt(i);
+                    hedged_request_count_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            continue;
+        }
+        const Clock::time_point wake_time = is_hedged ? deadline : std::min(deadline, hedge_time);
+        const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(wake_time - now) + std::chrono::milliseconds(1);
+
+        poll_fds.clear();
+        for (const Attempt& attempt : attempts) {
+            poll_fds.push_back({attempt.socket.GetFd(), POLLIN, 0});
+        }
+        if (poll(poll_fds.data(), poll_fds.size(), static_cast<int>(wait.count())) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("poll: "s + std::strerror(errno));
+        }
+
+        std::vector<Attempt> active_attempts;
+        std::vector<size_t> failed_calls;
+        for (size_t i = 0; i < attempts.size(); ++i) {
+            Attempt& attempt = attempts[i];
+            PendingCall& call = calls[attempt.call];
+            if (call.response) {
+                // Ответ уже получен от другой реплики; соединение с опоздавшей закрывается,
+                // чтобы её ответ не был прочитан следующим запросом
+                continue;
+            }
+            if (poll_fds[i].revents == 0) {
+                active_attempts.push_back(std::move(attempt));
+                continue;
+            }
+            std::optional<rpc::Message> response;
+            bool is_open = false;
+            try {
+                is_open = attempt.receiver.ReadAvailable(attempt.socket);
+                response = attempt.receiver.PopMessage();
+                if (!response && !is_open) {
+                    throw std::runtime_error("Соединение закрыто"s);
+                }
+            } catch (const std::exception& e) {
+                call.last_error = e.what();
+                if (--call.active_count == 0) {
+                    failed_calls.push_back(attempt.call);
+                }
+                continue;
+            }
+            if (!response) {
+                // Пришла только часть ответа: остальное дочитывается после следующего poll
+                active_attempts.push_back(std::move(attempt));
+                continue;
+            }
+            --call.active_count;
+            call.response = std::move(response);
+            ++done_count;
+            if (is_open && attempt.receiver.IsEmpty()) {
+                ReleaseSocket(*attempt.replica, std::move(attempt.socket));
+            }
+        }
+        attempts = std::move(active_attempts);
+        for (const size_t call_index : failed_calls) {
+            start_attempt(call_index);
+        }
+    }
+
+    std::vector<rpc::Message> responses;
+    responses.reserve(calls.size());
+    for (PendingCall& call : calls) {
+        responses.push_back(std::move(*call.response));
+    }
+    return responses;
+}
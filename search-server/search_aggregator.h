@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "document.h"
+#include "document_filter.h"
+#include "corpus_statistics.h"
+#include "rpc.h"
+
+struct AggregatorOptions {
+    // Если часть не ответила за это время, запрос дублируется на следующую её реплику
+    std::chrono::milliseconds hedge_delay{10};
+    // Предельное время ожидания ответов всех частей
+    std::chrono::milliseconds timeout{2000};
+};
+
+// Поиск по частям ShardService: документ id хранится в части id % GetShardCount().
+// Части ранжируют по общей статистике; медленная часть повторяется на другой реплике
+class SearchAggregator {
+public:
+    // Найденные слова передаются по сети, поэтому хранятся в строках
+    using MatchedDocument = std::tuple<std::vector<std::string>, DocumentStatus>;
+
+    // shard_addresses[i] — адреса реплик i-й части
+    explicit SearchAggregator(const std::vector<std::vector<std::string>>& shard_addresses, AggregatorOptions options = {});
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const DocumentFilter& filter) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    // Сумма статистик всех частей по плюс-словам запроса
+    CorpusStatistics GetCorpusStatistics(std::string_view raw_query) const;
+
+    MatchedDocument MatchDocument(std::string_view raw_query, int document_id) const;
+
+    size_t GetShardCount() const;
+    // Число повторных запросов, отправленных из-за медленного ответа
+    uint64_t GetHedgedRequestCount() const;
+
+private:
+    struct Replica {
+        std::string address;
+        std::mutex mutex;
+        std::vector<rpc::Socket> idle_sockets;
+    };
+
+    struct Shard {
+        std::vector<std::unique_ptr<Replica>> replicas;
+        std::atomic<size_t> next_replica = 0;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    const AggregatorOptions options_;
+    mutable std::atomic<uint64_t> hedged_request_count_ = 0;
+
+    rpc::Socket AcquireSocket(Replica& replica) const;
+    void ReleaseSocket(Replica& replica, rpc::Socket socket) const;
+
+    // Отправляет запрос частям shard_indexes и возвращает их ответы в том же порядке
+    std::vector<rpc::Message> Call(const std::vector<size_t>& shard_indexes, const std::string& request) const;
+    std::vector<rpc::Message> Broadcast(const std::string& request) const;
+};
@@ -3,50 +3,96 @@
 #include <stdexcept>
 #include <cmath>
 #include <numeric>
+#include <limits>
 
 using namespace std::string_literals;
 
-SearchServer::SearchServer(std::string_view stop_words_text)
-    : SearchServer(SplitIntoWords(stop_words_text))
+SearchServer::SearchServer(std::string_view stop_words_text, RankingFunction ranking_function)
+    : SearchServer(SplitIntoWords(stop_words_text), ranking_function)
 {
 }
 
-SearchServer::SearchServer(const std::string& stop_words_text)
-    : SearchServer(std::string_view(stop_words_text))
+SearchServer::SearchServer(const std::string& stop_words_text, RankingFunction ranking_function)
+    : SearchServer(std::string_view(stop_words_text), ranking_function)
 {
 }
 
 void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    CheckNewDocumentId(document_id);
+    AddTokenizedDocument(document_id, TokenizeDocument(document), status, ratings);
+}
+
+TokenizedDocument SearchServer::TokenizeDocument(std::string_view document) const {
+    const std::vector<std::string_view> words = SplitIntoWordsNoStop(document);
+    TokenizedDocument result;
+    result.length = static_cast<int>(words.size());
+    const double inv_word_count = 1.0 / words.size();
+    for (std::string_view word : words) {
+        result.word_frequencies[std::string(word)] += inv_word_count;
+    }
+    return result;
+}
+
+void SearchServer::AddTokenizedDocument(int document_id, TokenizedDocument document, DocumentStatus status, const std::vector<int>& ratings) {
+    CheckNewDocumentId(document_id);
+    if (document.length < 0) {
+        throw std::invalid_argument("Длина документа меньше нуля"s);
+    }
+    std::vector<std::string> words;
+    words.reserve(document.word_frequencies.size());
+    for (const auto& [word, term_freq] : document.word_frequencies) {
+        word_to_document_freqs_[word][document_id] = term_freq;
+        impact_postings_.Invalidate(word);
+        words.push_back(word);
+    }
+    document_lengths_[document_id] = document.length;
+    total_document_length_ += document.length;
+    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status, std::move(document.word_frequencies), std::move(words)});
+    documents_ids_.insert(document_id);
+    status_index_[static_cast<size_t>(status)].Insert(document_id);
+}
+
+void SearchServer::CheckNewDocumentId(int document_id) const {
     if (document_id < 0) {
         throw std::invalid_argument("id добавляемого докумета меньше нуля"s);
     }
     if (documents_.count(document_id)) {
         throw std::invalid_argument("id добавляемого документа уже существует"s);
     }
-    const std::vector<std::string_view> words = SplitIntoWordsNoStop(document);
-    std::map<std::string, double> words_to_save_with_document;
-    const double inv_word_count = 1.0 / words.size();
-    for (std::string_view word : words) {
-        word_to_document_freqs_[std::string(word)][document_id] += inv_word_count;
-        words_to_save_with_document[std::string(word)] += inv_word_count;
-    }
-    std::vector<std::string> words_without_duplicates(words.begin(), words.end());
-    std::sort(words_without_duplicates.begin(), words_without_duplicates.end());
-    auto last = std::unique(words_without_duplicates.begin(), words_without_duplicates.end());
-    words_without_duplicates.erase(last, words_without_duplicates.end());
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status, words_to_save_with_document, words_without_duplicates});
-    documents_ids_.insert(document_id);
-
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {return document_status == status;});
+    return FindTopDocuments(raw_query, DocumentFilter(status));
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const {
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
+SearchPage SearchServer::FindTopDocumentsPage(std::string_view raw_query, const PageCursor& cursor, size_t page_size, DocumentStatus status) const {
+    return FindTopDocumentsPage(raw_query, cursor, page_size, DocumentFilter(status));
+}
+
+SearchPage SearchServer::FindTopDocumentsPage(std::string_view raw_query, const PageCursor& cursor, size_t page_size) const {
+    return FindTopDocumentsPage(raw_query, cursor, page_size, DocumentStatus::ACTUAL);
+}
+
+DocumentStream<DocumentFilter> SearchServer::StreamTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return StreamTopDocuments(raw_query, DocumentFilter(status));
+}
+
+DocumentStream<DocumentFilter> SearchServer::StreamTopDocuments(std::string_view raw_query) const {
+    return StreamTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+ImpactSearchResult SearchServer::FindTopDocumentsByImpact(std::string_view raw_query, const ImpactSearchOptions& options, DocumentStatus status) const {
+    return FindTopDocumentsByImpact(raw_query, options, DocumentFilter(status));
+}
+
+ImpactSearchResult SearchServer::FindTopDocumentsByImpact(std::string_view raw_query, const ImpactSearchOptions& options) const {
+    return FindTopDocumentsByImpact(raw_query, options, DocumentStatus::ACTUAL);
+}
+
 int SearchServer::GetDocumentCount() const {
     return documents_.size();
 }
@@ -54,6 +100,7 @@ int SearchServer::GetDocumentCount() const {
 using MatchedDocument = std::tuple<std::vector<std::string_view>, DocumentStatus>;
 
 MatchedDocument SearchServer::MatchDocument(std::string_view raw_query, int document_id) const  {
+    LOG_STAGE(SearchStage::MATCH);
     if (documents_ids_.count(document_id) == 0) {
         throw std::out_of_range("document_id не существует"s);
     }
@@ -84,6 +131,7 @@ MatchedDocument SearchServer::MatchDocument(std::execution::sequenced_policy, st
 }
 
 MatchedDocument SearchServer::MatchDocument(std::execution::parallel_policy, std::string_view raw_query, int document_id) const {
+    LOG_STAGE(SearchStage::MATCH);
     if (documents_ids_.count(document_id) == 0) {
         throw std::out_of_range("document_id не существует"s);
     }
@@ -122,8 +170,91 @@ MatchedDocument SearchServer::MatchDocument(std::execution::parallel_policy, std
     return tie(matched_words, documents_.at(document_id).status);
 }
 
+// Если список документов слова длиннее запрошенного более чем в MERGE_RATIO раз,
+// выгоднее искать каждый документ, чем идти слиянием по всему списку
+constexpr size_t MERGE_RATIO = 2;
+
+std::vector<MatchedDocument> SearchServer::MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const {
+    LOG_STAGE(SearchStage::MATCH);
+    for (const int document_id : document_ids) {
+        if (documents_ids_.count(document_id) == 0) {
+            throw std::out_of_range("document_id не существует"s);
+        }
+    }
+
+    const Query query = ParseQuery(raw_query);
+
+    std::vector<size_t> order(document_ids.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&document_ids](size_t lhs, size_t rhs) {
+        return document_ids[lhs] < document_ids[rhs];
+    });
+
+    // Вызывает action для каждой позиции из positions, документ которой есть в word_freqs
+    const auto for_each_containing = [&document_ids](const std::map<int, double>& word_freqs, const std::vector<size_t>& positions, auto action) {
+        if (word_freqs.size() > positions.size() * MERGE_RATIO) {
+            for (const size_t position : positions) {
+                if (word_freqs.count(document_ids[position])) {
+                    action(position);
+                }
+            }
+            return;
+        }
+        auto posting = word_freqs.begin();
+        for (const size_t position : positions) {
+            while (posting != word_freqs.end() && posting->first < document_ids[position]) {
+                ++posting;
+            }
+            if (posting == word_freqs.end()) {
+                break;
+            }
+            if (posting->first == document_ids[position]) {
+                action(position);
+            }
+        }
+    };
+
+    std::vector<bool> has_minus_word(document_ids.size(), false);
+    for (std::string_view word : query.minus_words) {
+        const auto word_it = word_to_document_freqs_.find(std::string(word));
+        if (word_it == word_to_document_freqs_.end()) {
+            continue;
+        }
+        ADD_COUNTER(SearchCounter::POSTINGS_TOUCHED, word_it->second.size());
+        for_each_containing(word_it->second, order, [&has_minus_word](size_t position) {
+            has_minus_word[position] = true;
+        });
+    }
+    order.erase(std::remove_if(order.begin(), order.end(), [&has_minus_word](size_t position) {
+        return has_minus_word[position];
+    }), order.end());
+
+    std::vector<std::vector<std::string_view>> matched_words(document_ids.size());
+    for (std::string_view word : query.plus_words) {
+        if (order.empty()) {
+            break;
+        }
+        const auto word_it = word_to_document_freqs_.find(std::string(word));
+        if (word_it == word_to_document_freqs_.end()) {
+            continue;
+        }
+        ADD_COUNTER(SearchCounter::POSTINGS_TOUCHED, word_it->second.size());
+        const std::string_view stored_word = word_it->first;
+        for_each_containing(word_it->second, order, [&matched_words, stored_word](size_t position) {
+            matched_words[position].push_back(stored_word);
+        });
+    }
+
+    std::vector<MatchedDocument> result;
+    result.reserve(document_ids.size());
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        result.emplace_back(std::move(matched_words[i]), documents_.at(document_ids[i]).status);
+    }
+    return result;
+}
+
 bool SearchServer::IsStopWord(std::string_view word) const {
-    return stop_words_.count(std::string(word)) > 0;
+    return stop_words_.Contains(word);
 }
 
 bool SearchServer::CheckForSpecialSymbols(std::string_view text) const {
@@ -196,6 +327,7 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
 }
 
 SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool remove_duplicates) const {
+    LOG_STAGE(SearchStage::PARSE);
     Query query;
     const std::vector<std::string_view> words = SplitIntoWords(text);
     query.minus_words.reserve(words.size());
@@ -223,12 +355,30 @@ SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool remove_
     return query;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(std::string(word)).size());
+Scoring SearchServer::MakeScoring(const CorpusStatistics* statistics) const {
+    if (statistics != nullptr && statistics->document_count > 0) {
+        return ::MakeScoring(ranking_function_, statistics->total_document_length * 1.0 / statistics->document_count);
+    }
+    const double average_document_length = documents_.empty() ? 0.0 : total_document_length_ * 1.0 / documents_.size();
+    return ::MakeScoring(ranking_function_, average_document_length);
+}
+
+CorpusStatistics SearchServer::GetCorpusStatistics(std::string_view raw_query) const {
+    const Query query = ParseQuery(raw_query);
+    CorpusStatistics statistics;
+    statistics.document_count = GetDocumentCount();
+    statistics.total_document_length = total_document_length_;
+    for (std::string_view word : query.plus_words) {
+        const auto it = word_to_document_freqs_.find(std::string(word));
+        if (it != word_to_document_freqs_.end()) {
+            statistics.document_freqs.emplace(word, it->second.size());
+        }
+    }
+    return statistics;
 }
 
 const std::map<std::string, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    if (count(documents_ids_.begin(), documents_ids_.end(), document_id)) {
+    if (documents_ids_.count(document_id)) {
         return documents_.at(document_id).words_and_frequencies;
     } 
     else {
@@ -238,10 +388,33 @@ const std::map<std::string, double>& SearchServer::GetWordFrequencies(int docume
     }
 }
 
+DocumentStatus SearchServer::GetDocumentStatus(int document_id) const {
+    return documents_.at(document_id).status;
+}
+
+int SearchServer::GetDocumentRating(int document_id) const {
+    return documents_.at(document_id).rating;
+}
+
+int SearchServer::GetDocumentLength(int document_id) const {
+    if (documents_.count(document_id) == 0) {
+        throw std::out_of_range("document_id не существует"s);
+    }
+    return document_lengths_.at(document_id);
+}
+
+RankingFunction SearchServer::GetRankingFunction() const {
+    return ranking_function_;
+}
+
 void SearchServer::RemoveDocument(int document_id) {
-    for (auto [word, freq] : documents_.at(document_id).words_and_frequencies) {
+    for (const auto& [word, _] : documents_.at(document_id).words_and_frequencies) {
         word_to_document_freqs_.at(word).erase(document_id);
+        impact_postings_.Invalidate(word);
     }
+    EraseFromFilterIndexes(document_id);
+    total_document_length_ -= document_lengths_.at(document_id);
+    document_lengths_.erase(document_id);
     documents_.erase(document_id);
     documents_ids_.erase(document_id);
 }
@@ -254,7 +427,72 @@ void SearchServer::RemoveDocument(std::execution::parallel_policy, int document_
     std::for_each(std::execution::par, documents_.at(document_id).words.begin(), documents_.at(document_id).words.end(), 
     [this, document_id] (const std::string& word) {
         word_to_document_freqs_.at(word).erase(document_id);
+        impact_postings_.Invalidate(word);
     });
+    EraseFromFilterIndexes(document_id);
+    total_document_length_ -= document_lengths_.at(document_id);
+    document_lengths_.erase(document_id);
     documents_.erase(document_id);
     documents_ids_.erase(document_id);
-}
\ No newline at end of file
+}
+
+ImpactPostings::const_iterator SearchServer::FindImpactSegmentEnd(const ImpactPostings& postings, ImpactPostings::const_iterator segment_begin) {
+    const auto get_level_lower_edge = [](int level) {
+        return level + 1 >= IMPACT_LEVELS_COUNT ? 0.0 : std::pow(2.0, -(level + 1) / 2.0);
+    };
+    const double term_freq = segment_begin->first;
+    int level = std::clamp(static_cast<int>(-2.0 * std::log2(term_freq)), 0, IMPACT_LEVELS_COUNT - 1);
+    while (level + 1 < IMPACT_LEVELS_COUNT && !(term_freq > get_level_lower_edge(level))) {
+        ++level;
+    }
+    if (level + 1 >= IMPACT_LEVELS_COUNT) {
+        return postings.end();
+    }
+    const std::pair<double, int> level_edge{get_level_lower_edge(level), std::numeric_limits<int>::max()};
+    return std::lower_bound(segment_begin, postings.end(), level_edge, std::greater<>());
+}
+
+SearchServer::IndexedDocumentFilter SearchServer::MakeDocumentIdFilter(const DocumentFilter& filter) const {
+    IndexedDocumentFilter result;
+    result.search_server = this;
+    size_t status_count = 0;
+    for (size_t status = 0; status < DOCUMENT_STATUSES_COUNT; ++status) {
+        if (filter.HasStatus(static_cast<DocumentStatus>(status))) {
+            result.status_sets[status_count++] = &status_index_[status];
+        }
+    }
+    if (status_count == 0) {
+        // Ни один статус не подходит: пустое множество отсекает все документы
+        static const DocumentIdSet empty_set;
+        result.status_sets[status_count++] = &empty_set;
+    }
+    if (status_count < DOCUMENT_STATUSES_COUNT) {
+        result.status_set_count = status_count;
+    }
+    result.has_rating_range = filter.HasRatingRange();
+    result.min_rating = filter.min_rating;
+    result.max_rating = filter.max_rating;
+    return result;
+}
+
+bool SearchServer::IndexedDocumentFilter::operator()(int document_id) const {
+    if (status_set_count != 0) {
+        bool has_status = false;
+        for (size_t i = 0; i < status_set_count && !has_status; ++i) {
+            has_status = status_sets[i]->Contains(document_id);
+        }
+        if (!has_status) {
+            return false;
+        }
+    }
+    if (!has_rating_range) {
+        return true;
+    }
+    const int rating = search_server->documents_.at(document_id).rating;
+    return rating >= min_rating && rating <= max_rating;
+}
+
+void SearchServer::EraseFromFilterIndexes(int document_id) {
+    const DocumentData& document_data = documents_.at(document_id);
+    status_index_[static_cast<size_t>(document_data.status)].Erase(document_id);
+}
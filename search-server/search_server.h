@@ -7,25 +7,84 @@
 #include <stdexcept>
 #include <algorithm>
 #include <execution>
+#include <array>
+#include <utility>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <cstdint>
+#include <cmath>
 
 #include "document.h"
+#include "corpus_statistics.h"
+#include "scoring.h"
+#include "page_cursor.h"
+#include "document_filter.h"
+#include "document_id_set.h"
+#include "impact_postings_cache.h"
+#include "stop_words.h"
 #include "string_processing.h"
 #include "concurrent_map.h"
+#include "instrumentation.h"
 
 using namespace std::string_literals;
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 
+// Число квантованных уровней вклада: уровень i содержит term_freq из (2^(-(i+1)/2), 2^(-i/2)],
+// последний уровень — все меньшие значения
+constexpr int IMPACT_LEVELS_COUNT = 16;
+
+struct ImpactSearchOptions {
+    size_t top_k = MAX_RESULT_DOCUMENT_COUNT;
+    // Максимальное число просмотренных записей списков документов, 0 — без ограничения
+    size_t postings_budget = 0;
+};
+
+struct ImpactSearchResult {
+    std::vector<Document> documents;
+    // false, если поиск остановлен по бюджету и лучшие документы могли быть пропущены
+    bool is_exact = true;
+    size_t postings_processed = 0;
+};
+
+// Документ, разобранный на слова
+struct TokenizedDocument {
+    // Доля каждого слова среди слов документа
+    std::map<std::string, double> word_frequencies;
+    // Число слов без стоп-слов
+    int length = 0;
+};
+
+template <typename DocumentPredicate>
+class DocumentStream;
+
 class SearchServer {
 public:
     
+    // ranking_function задаёт формулу релевантности всех запросов, см. scoring.h
     template <typename StringContainer>
-    explicit SearchServer(const StringContainer& stop_words);
-    explicit SearchServer(std::string_view stop_words_text);
-    explicit SearchServer(const std::string& stop_words_text);
+    explicit SearchServer(const StringContainer& stop_words, RankingFunction ranking_function = RankingFunction::TF_IDF);
+    explicit SearchServer(std::string_view stop_words_text, RankingFunction ranking_function = RankingFunction::TF_IDF);
+    explicit SearchServer(const std::string& stop_words_text, RankingFunction ranking_function = RankingFunction::TF_IDF);
+    // Таблица стоп-слов построена на этапе компиляции, см. stop_words.h
+    template <size_t N>
+    explicit SearchServer(const StaticStopWords<N>& stop_words, RankingFunction ranking_function = RankingFunction::TF_IDF);
        
     void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
+    // Разбор текста отделён от изменения индекса: TokenizeDocument не меняет
+    // сервер и может выполняться параллельно, а AddTokenizedDocument добавляет
+    // документ с готовыми частотами слов. CheckNewDocumentId бросает то же
+    // исключение, что и AddDocument для недопустимого id, не меняя сервер
+    TokenizedDocument TokenizeDocument(std::string_view document) const;
+    void AddTokenizedDocument(int document_id, TokenizedDocument document, DocumentStatus status, const std::vector<int>& ratings);
+    void CheckNewDocumentId(int document_id) const;
+
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
@@ -38,6 +97,40 @@ public:
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query) const;
 
+    // IDF слов запроса вычисляется по переданной статистике, а не по этому серверу:
+    // так части распределённого корпуса ранжируют документы согласованно
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, const CorpusStatistics& statistics, DocumentPredicate document_predicate) const;
+
+    // Статистика этого сервера по плюс-словам запроса
+    CorpusStatistics GetCorpusStatistics(std::string_view raw_query) const;
+
+    template <typename DocumentPredicate>
+    SearchPage FindTopDocumentsPage(std::string_view raw_query, const PageCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const;
+    SearchPage FindTopDocumentsPage(std::string_view raw_query, const PageCursor& cursor, size_t page_size, DocumentStatus status) const;
+    SearchPage FindTopDocumentsPage(std::string_view raw_query, const PageCursor& cursor, size_t page_size) const;
+
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    SearchPage FindTopDocumentsPage(ExecutionPolicy policy, std::string_view raw_query, const PageCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const;
+    template <typename ExecutionPolicy>
+    SearchPage FindTopDocumentsPage(ExecutionPolicy policy, std::string_view raw_query, const PageCursor& cursor, size_t page_size, DocumentStatus status) const;
+    template <typename ExecutionPolicy>
+    SearchPage FindTopDocumentsPage(ExecutionPolicy policy, std::string_view raw_query, const PageCursor& cursor, size_t page_size) const;
+
+    // Ленивая выдача в порядке ранжирования, см. DocumentStream
+    template <typename DocumentPredicate>
+    DocumentStream<DocumentPredicate> StreamTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    DocumentStream<DocumentFilter> StreamTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    DocumentStream<DocumentFilter> StreamTopDocuments(std::string_view raw_query) const;
+
+    // Поиск «по вкладам»: сегменты списков документов всех слов обрабатываются
+    // от наибольшего вклада к наименьшему, пока первые top_k документов могут измениться
+    // и не исчерпан бюджет
+    template <typename DocumentPredicate>
+    ImpactSearchResult FindTopDocumentsByImpact(std::string_view raw_query, const ImpactSearchOptions& options, DocumentPredicate document_predicate) const;
+    ImpactSearchResult FindTopDocumentsByImpact(std::string_view raw_query, const ImpactSearchOptions& options, DocumentStatus status) const;
+    ImpactSearchResult FindTopDocumentsByImpact(std::string_view raw_query, const ImpactSearchOptions& options) const;
+
     int GetDocumentCount() const;
 
     using MatchedDocument = std::tuple<std::vector<std::string_view>, DocumentStatus>;
@@ -46,6 +139,10 @@ public:
     MatchedDocument MatchDocument(std::execution::sequenced_policy, std::string_view raw_query, int document_id) const;
     MatchedDocument MatchDocument(std::execution::parallel_policy, std::string_view raw_query, int document_id) const;
 
+    // Запрос разбирается один раз для всех документов. Найденные слова ссылаются
+    // на строки индекса и остаются действительными, пока слово есть в индексе.
+    std::vector<MatchedDocument> MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const;
+
     auto begin() const {
         return documents_ids_.begin();
     }
@@ -55,22 +152,44 @@ public:
     }
 
     const std::map<std::string, double>& GetWordFrequencies(int document_id) const;
+    DocumentStatus GetDocumentStatus(int document_id) const;
+    int GetDocumentRating(int document_id) const;
+    // Число слов документа без стоп-слов
+    int GetDocumentLength(int document_id) const;
+
+    RankingFunction GetRankingFunction() const;
 
     void RemoveDocument(int document_id);
     void RemoveDocument(std::execution::sequenced_policy, int document_id);
     void RemoveDocument(std::execution::parallel_policy, int document_id);
+
+    // Порядок выдачи: по убыванию релевантности, затем рейтинга, затем по возрастанию id
+    static bool IsRankedBefore(const Document& lhs, const Document& rhs);
     
 private:
+    // Тот же порядок без допуска по релевантности: в отличие от IsRankedBefore
+    // транзитивен, поэтому годится как ключ курсора страниц
+    static bool IsRankedBeforeExactly(const Document& lhs, const Document& rhs);
+
+    template <typename DocumentPredicate>
+    friend class DocumentStream;
+
     struct DocumentData {
         int rating;
         DocumentStatus status;
         std::map<std::string, double> words_and_frequencies;
         std::vector<std::string> words;
     };
-    const std::set<std::string> stop_words_;
+    const StopWords stop_words_;
+    const RankingFunction ranking_function_;
     std::map<std::string, std::map<int, double>> word_to_document_freqs_;
+    ImpactPostingsCache impact_postings_;
     std::map<int, DocumentData> documents_;
     std::set<int> documents_ids_; 
+    std::array<DocumentIdSet, DOCUMENT_STATUSES_COUNT> status_index_;
+    // Длины документов по id: цикл оценки читает длину без поиска в documents_
+    std::unordered_map<int, int> document_lengths_;
+    int64_t total_document_length_ = 0;
 
     bool IsStopWord(std::string_view word) const;
 
@@ -89,18 +208,53 @@ private:
     struct Query {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
+        // Внешняя статистика для IDF, nullptr — статистика этого сервера
+        const CorpusStatistics* statistics = nullptr;
     };
 
     Query ParseQuery(std::string_view text, bool remove_duplicates = true) const;
 
-    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+    template <typename ScoringPolicy>
+    double ComputeWordInverseDocumentFreq(std::string_view word, const CorpusStatistics* statistics) const;
+    // Политика оценки сервера; средняя длина документа берётся из statistics,
+    // nullptr — из этого сервера
+    Scoring MakeScoring(const CorpusStatistics* statistics) const;
+
+
+    // Проверка DocumentFilter по индексам статусов. Множества статусов не
+    // копируются, а рейтинг проверяется только у документов из списков слов.
+    struct IndexedDocumentFilter {
+        const SearchServer* search_server;
+        std::array<const DocumentIdSet*, DOCUMENT_STATUSES_COUNT> status_sets;
+        // 0 — подходят все статусы
+        size_t status_set_count = 0;
+        bool has_rating_range = false;
+        int min_rating = 0;
+        int max_rating = 0;
+
+        bool operator()(int document_id) const;
+    };
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
-    template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(std::execution::sequenced_policy, const Query& query, DocumentPredicate document_predicate) const;
-    template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(std::execution::parallel_policy, const Query& query, DocumentPredicate document_predicate) const;
+    auto MakeDocumentIdFilter(DocumentPredicate document_predicate) const;
+    IndexedDocumentFilter MakeDocumentIdFilter(const DocumentFilter& filter) const;
+    void EraseFromFilterIndexes(int document_id);
+
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const Query& query, DocumentPredicate document_predicate) const;
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    std::vector<Document> FindAllDocuments(const Query& query, const ScoringPolicy& scoring, DocumentPredicate document_predicate) const;
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    ImpactSearchResult FindAllDocumentsByImpact(const Query& query, const ImpactSearchOptions& options, const ScoringPolicy& scoring, DocumentPredicate document_predicate) const;
+
+    static ImpactPostings::const_iterator FindImpactSegmentEnd(const ImpactPostings& postings, ImpactPostings::const_iterator segment_begin);
+    // Длина документа для ComputeScore; политика, которой длина не нужна, не платит за поиск
+    template <typename ScoringPolicy>
+    int GetScoredDocumentLength(int document_id) const;
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    std::vector<Document> FindAllDocuments(std::execution::sequenced_policy, const Query& query, const ScoringPolicy& scoring, DocumentPredicate document_predicate) const;
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    std::vector<Document> FindAllDocuments(std::execution::parallel_policy, const Query& query, const ScoringPolicy& scoring, DocumentPredicate document_predicate) const;
 
     bool CheckForSpecialSymbols(std::string_view text) const;
 
@@ -111,8 +265,9 @@ private:
 
 
 template <typename StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words)
-    : stop_words_(MakeUniqueNonEmptyStrings(stop_words)) {
+SearchServer::SearchServer(const StringContainer& stop_words, RankingFunction ranking_function)
+    : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+    , ranking_function_(ranking_function) {
     for (std::string_view word : stop_words) {
         if (CheckForSpecialSymbols(word)) {
             throw std::invalid_argument("Стоп-слово содержит недопустимые символы"s);
@@ -120,8 +275,39 @@ SearchServer::SearchServer(const StringContainer& stop_words)
     }
 }
 
+template <size_t N>
+SearchServer::SearchServer(const StaticStopWords<N>& stop_words, RankingFunction ranking_function)
+    : stop_words_(stop_words)
+    , ranking_function_(ranking_function) {
+    for (std::string_view word : stop_words.GetWords()) {
+        if (word.empty() || CheckForSpecialSymbols(word)) {
+            throw std::invalid_argument("Стоп-слово содержит недопустимые символы"s);
+        }
+    }
+}
+
 constexpr double ALLOWABLE_ERROR = 1e-6;
 
+inline bool SearchServer::IsRankedBefore(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) >= ALLOWABLE_ERROR) {
+        return lhs.relevance > rhs.relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
+}
+
+inline bool SearchServer::IsRankedBeforeExactly(const Document& lhs, const Document& rhs) {
+    if (lhs.relevance != rhs.relevance) {
+        return lhs.relevance > rhs.relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
+}
+
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
     return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
@@ -130,15 +316,23 @@ std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
 template <typename DocumentPredicate, typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
     const Query query = ParseQuery(raw_query);
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
-    std::sort(policy, matched_documents.begin(), matched_documents.end(), 
-                [](const Document& lhs, const Document& rhs) {
-                 if (std::abs(lhs.relevance - rhs.relevance) < ALLOWABLE_ERROR) {
-                     return lhs.rating > rhs.rating;
-                 } else {
-                     return lhs.relevance > rhs.relevance;
-                 }
-                });
+    return FindTopDocuments(policy, query, document_predicate);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, const CorpusStatistics& statistics, DocumentPredicate document_predicate) const {
+    Query query = ParseQuery(raw_query);
+    query.statistics = &statistics;
+    return FindTopDocuments(policy, query, document_predicate);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, const Query& query, DocumentPredicate document_predicate) const {
+    auto matched_documents = std::visit([this, policy, &query, &document_predicate](const auto& scoring) {
+        return FindAllDocuments(policy, query, scoring, document_predicate);
+    }, MakeScoring(query.statistics));
+    LOG_STAGE(SearchStage::TOP_K);
+    std::sort(policy, matched_documents.begin(), matched_documents.end(), IsRankedBefore);
     if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
         matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
     }
@@ -147,7 +341,7 @@ std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std
 
 template <typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {return document_status == status;});
+    return FindTopDocuments(policy, raw_query, DocumentFilter(status));
 }
 
 template <typename ExecutionPolicy>
@@ -156,26 +350,309 @@ std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
+SearchPage SearchServer::FindTopDocumentsPage(std::string_view raw_query, const PageCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const {
+    return FindTopDocumentsPage(std::execution::seq, raw_query, cursor, page_size, document_predicate);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+SearchPage SearchServer::FindTopDocumentsPage(ExecutionPolicy, std::string_view raw_query, const PageCursor& cursor, size_t page_size, DocumentPredicate document_predicate) const {
+    const Query query = ParseQuery(raw_query);
+    // Курсор сравнивается с релевантностью точно, поэтому она должна повторяться
+    // от запроса к запросу: параллельный подсчёт складывает вклады слов в разном порядке
+    auto matched_documents = std::visit([this, &query, &document_predicate](const auto& scoring) {
+        return FindAllDocuments(std::execution::seq, query, scoring, document_predicate);
+    }, MakeScoring(query.statistics));
+    LOG_STAGE(SearchStage::TOP_K);
+    if (!cursor.IsStart()) {
+        const auto last = std::remove_if(matched_documents.begin(), matched_documents.end(),
+            [&cursor](const Document& document) {
+                return !IsRankedBeforeExactly(cursor.last_document_, document);
+            });
+        matched_documents.erase(last, matched_documents.end());
+    }
+    // Вместо полной сортировки выбираются page_size лучших документов и ещё один,
+    // по которому видно, есть ли следующая страница
+    const size_t selected_count = std::min(matched_documents.size(), page_size + 1);
+    std::partial_sort(matched_documents.begin(), matched_documents.begin() + selected_count, matched_documents.end(), IsRankedBeforeExactly);
+    SearchPage page;
+    page.has_more = matched_documents.size() > page_size;
+    matched_documents.resize(std::min(matched_documents.size(), page_size));
+    page.next_cursor = matched_documents.empty() ? cursor : PageCursor(matched_documents.back());
+    page.documents = std::move(matched_documents);
+    return page;
+}
+
+template <typename ExecutionPolicy>
+SearchPage SearchServer::FindTopDocumentsPage(ExecutionPolicy policy, std::string_view raw_query, const PageCursor& cursor, size_t page_size, DocumentStatus status) const {
+    return FindTopDocumentsPage(policy, raw_query, cursor, page_size, DocumentFilter(status));
+}
+
+template <typename ExecutionPolicy>
+SearchPage SearchServer::FindTopDocumentsPage(ExecutionPolicy policy, std::string_view raw_query, const PageCursor& cursor, size_t page_size) const {
+    return FindTopDocumentsPage(policy, raw_query, cursor, page_size, DocumentStatus::ACTUAL);
+}
+
+// Ленивая выдача в порядке ранжирования (алгоритм порогов Фейджина). Поток ссылается
+// на списки документов индекса: сервер нельзя изменять, пока поток используется
+template <typename DocumentPredicate>
+class DocumentStream {
+public:
+    DocumentStream(const SearchServer& search_server, std::string_view raw_query, DocumentPredicate document_predicate);
+
+    DocumentStream(const DocumentStream&) = delete;
+    DocumentStream& operator=(const DocumentStream&) = delete;
+    DocumentStream(DocumentStream&&) = default;
+
+    std::optional<Document> Next();
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Document;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Document*;
+        using reference = const Document&;
+
+        Iterator() = default;
+
+        explicit Iterator(DocumentStream* stream)
+            : stream_(stream)
+            , current_(stream->Next()) {
+        }
+
+        const Document& operator*() const {
+            return *current_;
+        }
+
+        const Document* operator->() const {
+            return &*current_;
+        }
+
+        Iterator& operator++() {
+            current_ = stream_->Next();
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return !current_ && !other.current_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        DocumentStream* stream_ = nullptr;
+        std::optional<Document> current_;
+    };
+
+    Iterator begin() {
+        return Iterator(this);
+    }
+
+    Iterator end() {
+        return Iterator();
+    }
+
+private:
+    struct TermCursor {
+        double inverse_document_freq;
+        const std::map<int, double>* document_freqs;
+        std::shared_ptr<const ImpactPostings> postings;
+        ImpactPostings::const_iterator current;
+    };
+
+    struct RankedAfter {
+        bool operator()(const Document& lhs, const Document& rhs) const {
+            return SearchServer::IsRankedBefore(rhs, lhs);
+        }
+    };
+
+    using DocumentFilterType = decltype(std::declval<const SearchServer&>().MakeDocumentIdFilter(std::declval<DocumentPredicate>()));
+
+    const SearchServer& search_server_;
+    DocumentFilterType document_filter_;
+    Scoring scoring_;
+    std::vector<TermCursor> terms_;
+    std::vector<const std::map<int, double>*> minus_document_freqs_;
+    std::unordered_set<int> seen_documents_;
+    std::priority_queue<Document, std::vector<Document>, RankedAfter> candidates_;
+
+    template <typename ScoringPolicy>
+    std::optional<Document> Next(const ScoringPolicy& scoring);
+    template <typename ScoringPolicy>
+    double ComputeThreshold(const ScoringPolicy& scoring) const;
+    template <typename ScoringPolicy>
+    bool ReadNextPosting(const ScoringPolicy& scoring);
+};
+
+template <typename DocumentPredicate>
+DocumentStream<DocumentPredicate> SearchServer::StreamTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return DocumentStream<DocumentPredicate>(*this, raw_query, document_predicate);
+}
+
+template <typename DocumentPredicate>
+DocumentStream<DocumentPredicate>::DocumentStream(const SearchServer& search_server, std::string_view raw_query, DocumentPredicate document_predicate)
+    : search_server_(search_server)
+    , document_filter_(search_server.MakeDocumentIdFilter(document_predicate))
+    , scoring_(search_server.MakeScoring(nullptr)) {
+    const SearchServer::Query query = search_server_.ParseQuery(raw_query);
     for (std::string_view word : query.plus_words) {
-        if (word_to_document_freqs_.count(std::string(word)) == 0) {
+        const auto freqs_it = search_server_.word_to_document_freqs_.find(std::string(word));
+        if (freqs_it == search_server_.word_to_document_freqs_.end() || freqs_it->second.empty()) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(std::string(word))) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
-            }
-        }
+        const double inverse_document_freq = std::visit([this, word, &query](const auto& scoring) {
+            using ScoringPolicy = std::decay_t<decltype(scoring)>;
+            return search_server_.template ComputeWordInverseDocumentFreq<ScoringPolicy>(word, query.statistics);
+        }, scoring_);
+        auto postings = search_server_.impact_postings_.Get(word, freqs_it->second);
+        const auto first = postings->begin();
+        terms_.push_back({inverse_document_freq, &freqs_it->second, std::move(postings), first});
     }
     for (std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(std::string(word)) == 0) {
+        const auto freqs_it = search_server_.word_to_document_freqs_.find(std::string(word));
+        if (freqs_it != search_server_.word_to_document_freqs_.end()) {
+            minus_document_freqs_.push_back(&freqs_it->second);
+        }
+    }
+}
+
+template <typename DocumentPredicate>
+std::optional<Document> DocumentStream<DocumentPredicate>::Next() {
+    // Политика выбирается один раз за вызов, цикл чтения специализирован для неё
+    return std::visit([this](const auto& scoring) {
+        return Next(scoring);
+    }, scoring_);
+}
+
+template <typename DocumentPredicate>
+template <typename ScoringPolicy>
+std::optional<Document> DocumentStream<DocumentPredicate>::Next(const ScoringPolicy& scoring) {
+    while (true) {
+        if (!candidates_.empty() && candidates_.top().relevance - ComputeThreshold(scoring) >= ALLOWABLE_ERROR) {
+            break;
+        }
+        if (!ReadNextPosting(scoring)) {
+            break;
+        }
+    }
+    if (candidates_.empty()) {
+        return std::nullopt;
+    }
+    Document result = candidates_.top();
+    candidates_.pop();
+    return result;
+}
+
+template <typename DocumentPredicate>
+template <typename ScoringPolicy>
+double DocumentStream<DocumentPredicate>::ComputeThreshold(const ScoringPolicy& scoring) const {
+    double threshold = 0.0;
+    for (const TermCursor& term : terms_) {
+        if (term.current != term.postings->end()) {
+            threshold += scoring.ComputeUpperBound(term.current->first, term.inverse_document_freq);
+        }
+    }
+    return threshold;
+}
+
+template <typename DocumentPredicate>
+template <typename ScoringPolicy>
+bool DocumentStream<DocumentPredicate>::ReadNextPosting(const ScoringPolicy& scoring) {
+    // Сначала читается слово с наибольшим текущим вкладом: так порог падает быстрее всего
+    TermCursor* best_term = nullptr;
+    double best_bound = 0.0;
+    for (TermCursor& term : terms_) {
+        if (term.current == term.postings->end()) {
             continue;
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(std::string(word))) {
-            document_to_relevance.erase(document_id);
+        const double bound = scoring.ComputeUpperBound(term.current->first, term.inverse_document_freq);
+        if (best_term == nullptr || bound > best_bound) {
+            best_term = &term;
+            best_bound = bound;
+        }
+    }
+    if (best_term == nullptr) {
+        return false;
+    }
+    const int document_id = best_term->current->second;
+    ++best_term->current;
+    ADD_COUNTER(SearchCounter::POSTINGS_TOUCHED, 1);
+    if (!seen_documents_.insert(document_id).second) {
+        return true;
+    }
+    if (!document_filter_(document_id)) {
+        return true;
+    }
+    for (const auto* minus_freqs : minus_document_freqs_) {
+        if (minus_freqs->count(document_id)) {
+            return true;
+        }
+    }
+    double relevance = 0.0;
+    for (const TermCursor& term : terms_) {
+        const auto freq_it = term.document_freqs->find(document_id);
+        if (freq_it != term.document_freqs->end()) {
+            relevance += scoring.ComputeScore(freq_it->second, search_server_.template GetScoredDocumentLength<ScoringPolicy>(document_id), term.inverse_document_freq);
+        }
+    }
+    ADD_COUNTER(SearchCounter::DOCUMENTS_SCORED, 1);
+    candidates_.push({document_id, relevance, search_server_.documents_.at(document_id).rating});
+    return true;
+}
+
+template <typename ScoringPolicy>
+double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word, const CorpusStatistics* statistics) const {
+    if (statistics != nullptr) {
+        const auto it = statistics->document_freqs.find(word);
+        if (it != statistics->document_freqs.end() && it->second > 0) {
+            return ScoringPolicy::ComputeInverseDocumentFreq(statistics->document_count, it->second);
+        }
+    }
+    return ScoringPolicy::ComputeInverseDocumentFreq(GetDocumentCount(), static_cast<int>(word_to_document_freqs_.at(std::string(word)).size()));
+}
+
+template <typename DocumentPredicate>
+auto SearchServer::MakeDocumentIdFilter(DocumentPredicate document_predicate) const {
+    return [this, document_predicate](int document_id) {
+        const auto& document_data = documents_.at(document_id);
+        return document_predicate(document_id, document_data.status, document_data.rating);
+    };
+}
+
+template <typename DocumentPredicate, typename ScoringPolicy>
+std::vector<Document> SearchServer::FindAllDocuments(const Query& query, const ScoringPolicy& scoring, DocumentPredicate document_predicate) const {
+    std::map<int, double> document_to_relevance;
+    {
+        LOG_STAGE(SearchStage::POSTING_SCAN);
+        const auto document_filter = MakeDocumentIdFilter(document_predicate);
+        for (std::string_view word : query.plus_words) {
+            if (word_to_document_freqs_.count(std::string(word)) == 0) {
+                continue;
+            }
+            const double inverse_document_freq = ComputeWordInverseDocumentFreq<ScoringPolicy>(word, query.statistics);
+            const auto& word_freqs = word_to_document_freqs_.at(std::string(word));
+            ADD_COUNTER(SearchCounter::POSTINGS_TOUCHED, word_freqs.size());
+            for (const auto [document_id, term_freq] : word_freqs) {
+                if (document_filter(document_id)) {
+                    document_to_relevance[document_id] += scoring.ComputeScore(term_freq, GetScoredDocumentLength<ScoringPolicy>(document_id), inverse_document_freq);
+                }
+            }
+        }
+        ADD_COUNTER(SearchCounter::DOCUMENTS_SCORED, document_to_relevance.size());
+    }
+    {
+        LOG_STAGE(SearchStage::MINUS_FILTER);
+        for (std::string_view word : query.minus_words) {
+            if (word_to_document_freqs_.count(std::string(word)) == 0) {
+                continue;
+            }
+            const auto& word_freqs = word_to_document_freqs_.at(std::string(word));
+            ADD_COUNTER(SearchCounter::POSTINGS_TOUCHED, word_freqs.size());
+            for (const auto [document_id, _] : word_freqs) {
+                document_to_relevance.erase(document_id);
+            }
         }
     }
     std::vector<Document> matched_documents;
@@ -186,40 +663,216 @@ std::vector<Document> SearchServer::FindAllDocuments(const Query& query, Documen
     return matched_documents;
 }
 
+template <typename ScoringPolicy>
+int SearchServer::GetScoredDocumentLength(int document_id) const {
+    if constexpr (ScoringPolicy::USES_DOCUMENT_LENGTH) {
+        return document_lengths_.at(document_id);
+    } else {
+        return 0;
+    }
+}
+
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(std::execution::sequenced_policy, const Query& query, DocumentPredicate document_predicate) const {
-    return FindAllDocuments(query, document_predicate);
+ImpactSearchResult SearchServer::FindTopDocumentsByImpact(std::string_view raw_query, const ImpactSearchOptions& options, DocumentPredicate document_predicate) const {
+    const Query query = ParseQuery(raw_query);
+    return std::visit([this, &query, &options, &document_predicate](const auto& scoring) {
+        return FindAllDocumentsByImpact(query, options, scoring, document_predicate);
+    }, MakeScoring(query.statistics));
 }
 
-constexpr size_t BUCKETS_COUNT = 100;
+template <typename DocumentPredicate, typename ScoringPolicy>
+ImpactSearchResult SearchServer::FindAllDocumentsByImpact(const Query& query, const ImpactSearchOptions& options, const ScoringPolicy& scoring, DocumentPredicate document_predicate) const {
+    struct TermSegments {
+        double inverse_document_freq;
+        std::shared_ptr<const ImpactPostings> postings;
+        const std::map<int, double>* document_freqs;
+        ImpactPostings::const_iterator segment_begin;
+        double bound;
+    };
+    std::vector<TermSegments> terms;
+    for (std::string_view word : query.plus_words) {
+        const auto freqs_it = word_to_document_freqs_.find(std::string(word));
+        if (freqs_it == word_to_document_freqs_.end() || freqs_it->second.empty()) {
+            continue;
+        }
+        const double inverse_document_freq = ComputeWordInverseDocumentFreq<ScoringPolicy>(word, query.statistics);
+        auto postings = impact_postings_.Get(word, freqs_it->second);
+        const auto first = postings->begin();
+        const double bound = scoring.ComputeUpperBound(first->first, inverse_document_freq);
+        terms.push_back({inverse_document_freq, std::move(postings), &freqs_it->second, first, bound});
+    }
+    std::unordered_set<int> excluded_documents;
+    {
+        LOG_STAGE(SearchStage::MINUS_FILTER);
+        for (std::string_view word : query.minus_words) {
+            const auto freqs_it = word_to_document_freqs_.find(std::string(word));
+            if (freqs_it == word_to_document_freqs_.end()) {
+                continue;
+            }
+            ADD_COUNTER(SearchCounter::POSTINGS_TOUCHED, freqs_it->second.size());
+            for (const auto [document_id, _] : freqs_it->second) {
+                excluded_documents.insert(document_id);
+            }
+        }
+    }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(std::execution::parallel_policy, const Query& query, DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(BUCKETS_COUNT);
-    std::for_each(std::execution::par, query.plus_words.begin(), query.plus_words.end(), 
-    [this, &document_to_relevance, document_predicate] (std::string_view word) {
-        if (word_to_document_freqs_.count(std::string(word)) == 0) {
-            return;
+    ImpactSearchResult result;
+    std::unordered_map<int, double> document_to_relevance;
+    const auto document_filter = MakeDocumentIdFilter(document_predicate);
+    const auto top_k = std::max<size_t>(options.top_k, 1);
+    // Наибольший возможный остаток релевантности документа: сумма оценок следующих сегментов
+    const auto compute_remaining_bound = [&terms]() {
+        double bound = 0.0;
+        for (const TermSegments& term : terms) {
+            bound += term.bound;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(std::string(word))) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
+        return bound;
+    };
+    const auto compute_kth_relevance = [&document_to_relevance, top_k]() {
+        std::vector<double> relevances;
+        relevances.reserve(document_to_relevance.size());
+        for (const auto [_, relevance] : document_to_relevance) {
+            relevances.push_back(relevance);
+        }
+        std::nth_element(relevances.begin(), relevances.begin() + (top_k - 1), relevances.end(), std::greater<>());
+        return relevances[top_k - 1];
+    };
+    // Первые top_k не изменятся, если ни один другой документ не догонит k-й даже с максимальным остатком
+    const auto is_top_k_final = [&document_to_relevance, top_k](double kth_relevance, double remaining_bound) {
+        size_t above_count = 0;
+        for (const auto [_, relevance] : document_to_relevance) {
+            if (relevance >= kth_relevance) {
+                ++above_count;
+            } else if (relevance + remaining_bound > kth_relevance - ALLOWABLE_ERROR) {
+                return false;
             }
         }
-    });
-    std::for_each(std::execution::par, query.minus_words.begin(), query.minus_words.end(),
-    [this, &document_to_relevance] (std::string_view word) {
-        if (word_to_document_freqs_.count(std::string(word)) == 0) {
-            return;
+        return above_count <= top_k;
+    };
+
+    {
+        LOG_STAGE(SearchStage::POSTING_SCAN);
+        double kth_relevance = 0.0;
+        size_t next_kth_check = top_k;
+        while (true) {
+            // Слово с наибольшей оценкой среди непрочитанных. Нулевая оценка не повод
+            // остановиться: такие записи ещё не найденных документов тоже входят в выдачу
+            auto term = std::max_element(terms.begin(), terms.end(), [](const TermSegments& lhs, const TermSegments& rhs) {
+                return std::pair(lhs.segment_begin != lhs.postings->end(), lhs.bound)
+                    < std::pair(rhs.segment_begin != rhs.postings->end(), rhs.bound);
+            });
+            if (term == terms.end() || term->segment_begin == term->postings->end()) {
+                break;
+            }
+            const double remaining_bound = compute_remaining_bound();
+            if (document_to_relevance.size() >= top_k) {
+                if (result.postings_processed >= next_kth_check || remaining_bound < kth_relevance) {
+                    kth_relevance = compute_kth_relevance();
+                    next_kth_check = result.postings_processed * 2;
+                }
+                if (remaining_bound <= kth_relevance - ALLOWABLE_ERROR && is_top_k_final(kth_relevance, remaining_bound)) {
+                    break;
+                }
+            }
+            if (options.postings_budget != 0 && result.postings_processed >= options.postings_budget) {
+                result.is_exact = false;
+                break;
+            }
+            const auto segment_end = FindImpactSegmentEnd(*term->postings, term->segment_begin);
+            auto it = term->segment_begin;
+            for (; it != segment_end; ++it) {
+                // Бюджет проверяется на каждой записи: длинный сегмент не должен его превышать
+                if (options.postings_budget != 0 && result.postings_processed >= options.postings_budget) {
+                    result.is_exact = false;
+                    break;
+                }
+                const auto [term_freq, document_id] = *it;
+                ++result.postings_processed;
+                if (excluded_documents.count(document_id) == 0 && document_filter(document_id)) {
+                    document_to_relevance[document_id] += scoring.ComputeScore(term_freq, GetScoredDocumentLength<ScoringPolicy>(document_id), term->inverse_document_freq);
+                }
+            }
+            // При остановке внутри сегмента его непрочитанная часть остаётся началом следующего
+            term->segment_begin = it;
+            term->bound = it == term->postings->end() ? 0.0 : scoring.ComputeUpperBound(it->first, term->inverse_document_freq);
+            if (!result.is_exact) {
+                break;
+            }
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(std::string(word))) {
-            document_to_relevance.erase(document_id);
+        ADD_COUNTER(SearchCounter::POSTINGS_TOUCHED, result.postings_processed);
+        ADD_COUNTER(SearchCounter::DOCUMENTS_SCORED, document_to_relevance.size());
+    }
+
+    LOG_STAGE(SearchStage::TOP_K);
+    std::vector<Document> matched_documents;
+    matched_documents.reserve(document_to_relevance.size());
+    for (const auto [document_id, relevance] : document_to_relevance) {
+        matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+    }
+    const size_t selected_count = std::min(matched_documents.size(), top_k);
+    std::partial_sort(matched_documents.begin(), matched_documents.begin() + selected_count, matched_documents.end(), IsRankedBefore);
+    matched_documents.resize(selected_count);
+    // При ранней остановке накопленная релевантность может быть неполной: досчитываем её
+    for (Document& document : matched_documents) {
+        document.relevance = 0.0;
+        for (const TermSegments& term : terms) {
+            const auto freq_it = term.document_freqs->find(document.id);
+            if (freq_it != term.document_freqs->end()) {
+                document.relevance += scoring.ComputeScore(freq_it->second, GetScoredDocumentLength<ScoringPolicy>(document.id), term.inverse_document_freq);
+            }
         }
-    });
+    }
+    std::sort(matched_documents.begin(), matched_documents.end(), IsRankedBefore);
+    result.documents = std::move(matched_documents);
+    return result;
+}
+
+template <typename DocumentPredicate, typename ScoringPolicy>
+std::vector<Document> SearchServer::FindAllDocuments(std::execution::sequenced_policy, const Query& query, const ScoringPolicy& scoring, DocumentPredicate document_predicate) const {
+    return FindAllDocuments(query, scoring, document_predicate);
+}
+
+constexpr size_t BUCKETS_COUNT = 100;
+
+template <typename DocumentPredicate, typename ScoringPolicy>
+std::vector<Document> SearchServer::FindAllDocuments(std::execution::parallel_policy, const Query& query, const ScoringPolicy& scoring, DocumentPredicate document_predicate) const {
+    ConcurrentMap<int, double> document_to_relevance(BUCKETS_COUNT);
+    {
+        LOG_STAGE(SearchStage::POSTING_SCAN);
+        const auto document_filter = MakeDocumentIdFilter(document_predicate);
+        std::for_each(std::execution::par, query.plus_words.begin(), query.plus_words.end(), 
+        [this, &query, &scoring, &document_to_relevance, &document_filter] (std::string_view word) {
+            if (word_to_document_freqs_.count(std::string(word)) == 0) {
+                return;
+            }
+            const double inverse_document_freq = ComputeWordInverseDocumentFreq<ScoringPolicy>(word, query.statistics);
+            const auto& word_freqs = word_to_document_freqs_.at(std::string(word));
+            ADD_COUNTER(SearchCounter::POSTINGS_TOUCHED, word_freqs.size());
+            for (const auto [document_id, term_freq] : word_freqs) {
+                if (document_filter(document_id)) {
+                    document_to_relevance[document_id].ref_to_value += scoring.ComputeScore(term_freq, GetScoredDocumentLength<ScoringPolicy>(document_id), inverse_document_freq);
+                }
+            }
+        });
+    }
+    {
+        LOG_STAGE(SearchStage::MINUS_FILTER);
+        std::for_each(std::execution::par, query.minus_words.begin(), query.minus_words.end(),
+        [this, &document_to_relevance] (std::string_view word) {
+            if (word_to_document_freqs_.count(std::string(word)) == 0) {
+                return;
+            }
+            const auto& word_freqs = word_to_document_freqs_.at(std::string(word));
+            ADD_COUNTER(SearchCounter::POSTINGS_TOUCHED, word_freqs.size());
+            for (const auto [document_id, _] : word_freqs) {
+                document_to_relevance.erase(document_id);
+            }
+        });
+    }
+    const std::map<int, double> document_to_relevance_map = document_to_relevance.BuildOrdinaryMap();
+    ADD_COUNTER(SearchCounter::DOCUMENTS_SCORED, document_to_relevance_map.size());
     std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
+    for (const auto [document_id, relevance] : document_to_relevance_map) {
         matched_documents.push_back(
             {document_id, relevance, documents_.at(document_id).rating});
     }
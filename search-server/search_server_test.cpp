@@ -0,0 +1,36 @@
+#include "search_server.h"
+#include <cassert>
+#include <execution>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Проверки поиска, которые нельзя увидеть по замерам benchmark.cpp
+
+void TestImpactSearchReadsZeroScoreWords(RankingFunction ranking_function) {
+    // С TF-IDF у слова, которое есть во всех документах, IDF и верхняя оценка
+    // вклада равны нулю, но документы с ним всё равно входят в выдачу
+    SearchServer search_server(""s, ranking_function);
+    search_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat"s, DocumentStatus::ACTUAL, {2});
+    const vector<Document> expected = search_server.FindTopDocuments("cat"s);
+    assert(expected.size() == 2);
+    const ImpactSearchResult result = search_server.FindTopDocumentsByImpact("cat"s, {});
+    assert(result.is_exact);
+    assert(result.documents.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        assert(result.documents[i].id == expected[i].id);
+    }
+    size_t streamed_count = 0;
+    for (auto stream = search_server.StreamTopDocuments("cat"s); stream.Next();) {
+        ++streamed_count;
+    }
+    assert(streamed_count == expected.size());
+}
+
+int main() {
+    TestImpactSearchReadsZeroScoreWords(RankingFunction::TF_IDF);
+    TestImpactSearchReadsZeroScoreWords(RankingFunction::BM25);
+    cout << "OK"s << endl;
+}
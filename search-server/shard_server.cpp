@@ -0,0 +1,54 @@
+#include "search_server.h"
+#include "shard_service.h"
+#include "command_line.h"
+#include "corpus_io.h"
+#include <csignal>
+#include <iostream>
+#include <string>
+using namespace std;
+
+// Процесс части распределённого индекса:
+//  shard_server --listen=unix:/tmp/shard0.sock --corpus=corpus.tsv --shard=0 --shards=2 --workers=8 --ranking=bm25
+
+namespace {
+
+ShardService* running_service = nullptr;
+
+extern "C" void HandleStopSignal(int) {
+    if (running_service != nullptr) {
+        running_service->Stop();
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        const CommandLineOptions options(argc, argv, 1);
+        const int shard_count = options.Get("shards"s, 1);
+        const int shard_index = options.Get("shard"s, 0);
+        if (shard_count <= 0 || shard_index < 0 || shard_index >= shard_count) {
+            throw invalid_argument("Некорректный номер части индекса"s);
+        }
+        SearchServer search_server(options.GetString("stop-words"s, ""s), ParseRankingFunction(options.GetString("ranking"s, "tf-idf"s)));
+        LoadCorpus(search_server, options.GetString("corpus"s, "corpus.tsv"s), shard_index, shard_count);
+        rpc::Listener listener(options.GetString("listen"s, "127.0.0.1:7000"s));
+        cerr << "Часть "s << shard_index << " из "s << shard_count << ": "s
+             << search_server.GetDocumentCount() << " документов"s << endl;
+        ShardServiceOptions service_options;
+        const int worker_count = options.Get("workers"s, static_cast<int>(service_options.worker_count));
+        if (worker_count <= 0) {
+            throw invalid_argument("Некорректное число рабочих потоков"s);
+        }
+        service_options.worker_count = static_cast<size_t>(worker_count);
+        ShardService service(search_server, service_options);
+        running_service = &service;
+        signal(SIGINT, HandleStopSignal);
+        signal(SIGTERM, HandleStopSignal);
+        service.Serve(listener);
+        running_service = nullptr;
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
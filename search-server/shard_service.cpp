@@ -0,0 +1,216 @@
+#include "shard_service.h"
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace std::string_literals;
+
+ShardService::ShardService(const SearchServer& search_server, ShardServiceOptions options)
+    : search_server_(search_server)
+    , options_(options)
+{
+    if (options_.worker_count == 0) {
+        throw std::invalid_argument("Нужен хотя бы один рабочий поток"s);
+    }
+    if (pipe2(wake_fds_, O_CLOEXEC | O_NONBLOCK) != 0) {
+        throw std::runtime_error("pipe: "s + std::strerror(errno));
+    }
+}
+
+ShardService::~ShardService() {
+    close(wake_fds_[0]);
+    close(wake_fds_[1]);
+}
+
+std::string ShardService::HandleRequest(const rpc::Message& request) const {
+    try {
+        rpc::MessageReader reader(request.body);
+        switch (request.type) {
+            case rpc::MessageType::STATISTICS_REQUEST: {
+                const std::string_view raw_query = reader.ReadString();
+                rpc::MessageWriter writer(rpc::MessageType::STATISTICS_RESPONSE);
+                rpc::WriteStatistics(writer, search_server_.GetCorpusStatistics(raw_query));
+                return writer.Finish();
+            }
+            case rpc::MessageType::SEARCH_REQUEST: {
+                const std::string_view raw_query = reader.ReadString();
+                const CorpusStatistics statistics = rpc::ReadStatistics(reader);
+                const DocumentFilter filter = rpc::ReadFilter(reader);
+                rpc::MessageWriter writer(rpc::MessageType::SEARCH_RESPONSE);
+                rpc::WriteDocuments(writer, search_server_.FindTopDocuments(std::execution::seq, raw_query, statistics, filter));
+                return writer.Finish();
+            }
+            case rpc::MessageType::MATCH_REQUEST: {
+                const std::string_view raw_query = reader.ReadString();
+                const int document_id = reader.ReadInt32();
+                const auto [words, status] = search_server_.MatchDocument(std::execution::par, raw_query, document_id);
+                rpc::MessageWriter writer(rpc::MessageType::MATCH_RESPONSE);
+                writer.WriteUint32(static_cast<uint32_t>(words.size()));
+                for (std::string_view word : words) {
+                    writer.WriteString(word);
+                }
+                writer.WriteUint32(static_cast<uint32_t>(status));
+                return writer.Finish();
+            }
+            default:
+                return rpc::MakeErrorResponse(rpc::ErrorKind::INVALID_ARGUMENT, "Неизвестный тип запроса"s);
+        }
+    } catch (const std::invalid_argument& e) {
+        return rpc::MakeErrorResponse(rpc::ErrorKind::INVALID_ARGUMENT, e.what());
+    } catch (const std::out_of_range& e) {
+        return rpc::MakeErrorResponse(rpc::ErrorKind::OUT_OF_RANGE, e.what());
+    } catch (const std::exception& e) {
+        return rpc::MakeErrorResponse(rpc::ErrorKind::OTHER, e.what());
+    }
+}
+
+void ShardService::Serve(rpc::Listener& listener) {
+    // Соединения объявлены раньше потоков: рабочие потоки завершаются, пока соединения ещё открыты
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::vector<std::thread> workers;
+    const auto stop_workers = [this, &workers]() {
+        {
+            std::lock_guard guard(mutex_);
+            is_shutting_down_ = true;
+        }
+        task_condition_.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        std::lock_guard guard(mutex_);
+        is_shutting_down_ = false;
+        tasks_.clear();
+        finished_requests_.clear();
+    };
+
+    try {
+        workers.reserve(options_.worker_count);
+        for (size_t i = 0; i < options_.worker_count; ++i) {
+            workers.emplace_back(&ShardService::RunWorker, this);
+        }
+        std::vector<pollfd> poll_fds;
+        std::vector<Connection*> polled_connections;
+        while (!is_stopped_.load()) {
+            std::vector<FinishedRequest> finished_requests;
+            {
+                std::lock_guard guard(mutex_);
+                finished_requests.swap(finished_requests_);
+            }
+            for (const auto [connection, is_failed] : finished_requests) {
+                connection->is_busy = false;
+                connection->is_failed = connection->is_failed || is_failed;
+                if (!connection->is_failed) {
+                    DispatchRequest(*connection);
+                }
+            }
+            connections.erase(std::remove_if(connections.begin(), connections.end(), [](const auto& connection) {
+                return !connection->is_busy && connection->is_failed;
+            }), connections.end());
+
+            poll_fds.assign({{wake_fds_[0], POLLIN, 0}, {listener.GetFd(), POLLIN, 0}});
+            polled_connections.clear();
+            for (const auto& connection : connections) {
+                if (!connection->is_busy) {
+                    poll_fds.push_back({connection->socket.GetFd(), POLLIN, 0});
+                    polled_connections.push_back(connection.get());
+                }
+            }
+            if (poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("poll: "s + std::strerror(errno));
+            }
+            if (poll_fds[0].revents != 0) {
+                char buffer[64];
+                while (read(wake_fds_[0], buffer, sizeof(buffer)) > 0) {
+                }
+            }
+            if (poll_fds[1].revents != 0) {
+                rpc::Socket socket = listener.Accept();
+                // Сокет сверх предела закрывается сразу, агрегатор повторит запрос на другой реплике
+                if (socket.IsValid() && connections.size() < options_.max_connection_count) {
+                    socket.SetTimeout(options_.send_timeout);
+                    connections.push_back(std::make_unique<Connection>());
+                    connections.back()->socket = std::move(socket);
+                }
+            }
+            for (size_t i = 0; i < polled_connections.size(); ++i) {
+                if (poll_fds[i + 2].revents == 0) {
+                    continue;
+                }
+                Connection& connection = *polled_connections[i];
+                try {
+                    const bool is_open = connection.receiver.ReadAvailable(connection.socket);
+                    if (!DispatchRequest(connection) && !is_open) {
+                        connection.is_failed = true;
+                    }
+                } catch (const std::exception&) {
+                    connection.is_failed = true;
+                }
+            }
+        }
+    } catch (...) {
+        stop_workers();
+        throw;
+    }
+    stop_workers();
+}
+
+void ShardService::Stop() {
+    is_stopped_.store(true);
+    Wake();
+}
+
+bool ShardService::DispatchRequest(Connection& connection) {
+    std::optional<rpc::Message> request = connection.receiver.PopMessage();
+    if (!request) {
+        return false;
+    }
+    connection.is_busy = true;
+    {
+        std::lock_guard guard(mutex_);
+        tasks_.push_back({&connection, std::move(*request)});
+    }
+    task_condition_.notify_one();
+    return true;
+}
+
+void ShardService::RunWorker() {
+    while (true) {
+        std::unique_lock lock(mutex_);
+        task_condition_.wait(lock, [this]() {
+            return is_shutting_down_ || !tasks_.empty();
+        });
+        if (is_shutting_down_) {
+            return;
+        }
+        Task task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lock.unlock();
+
+        bool is_failed = false;
+        try {
+            task.connection->socket.Send(HandleRequest(task.request));
+        } catch (const std::exception&) {
+            // Агрегатор закрывает соединение, не дожидаясь ответа, если получил его от другой реплики
+            is_failed = true;
+        }
+        lock.lock();
+        finished_requests_.push_back({task.connection, is_failed});
+        lock.unlock();
+        Wake();
+    }
+}
+
+void ShardService::Wake() {
+    const char byte = 0;
+    // Переполненный канал и так разбудит poll, поэтому ошибка записи не важна
+    [[maybe_unused]] const ssize_t written = write(wake_fds_[1], &byte, 1);
+}
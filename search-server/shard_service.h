@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rpc.h"
+#include "search_server.h"
+
+struct ShardServiceOptions {
+    // Потоки, выполняющие запросы
+    size_t worker_count = std::max(1u, std::thread::hardware_concurrency());
+    // Соединения сверх этого числа закрываются сразу после принятия
+    size_t max_connection_count = 1024;
+    // Соединение закрывается, если ответ не удалось отправить за это время
+    std::chrono::milliseconds send_timeout{2000};
+};
+
+// Часть распределённого индекса: цикл poll читает соединения, пул потоков выполняет запросы
+class ShardService {
+public:
+    explicit ShardService(const SearchServer& search_server, ShardServiceOptions options = {});
+    ShardService(const ShardService&) = delete;
+    ShardService& operator=(const ShardService&) = delete;
+    ~ShardService();
+
+    // Формирует ответ на одно сообщение
+    std::string HandleRequest(const rpc::Message& request) const;
+
+    // Обслуживает соединения, пока не вызван Stop или не возникла ошибка listener.
+    // Перед возвратом дожидается рабочих потоков и закрывает соединения
+    void Serve(rpc::Listener& listener);
+    // Завершает Serve. Можно вызывать из другого потока и из обработчика сигнала
+    void Stop();
+
+private:
+    struct Connection {
+        rpc::Socket socket;
+        rpc::MessageReceiver receiver;
+        // Запрос соединения выполняет рабочий поток, и цикл poll его не читает.
+        // Оба поля читает и пишет только поток Serve
+        bool is_busy = false;
+        bool is_failed = false;
+    };
+
+    struct FinishedRequest {
+        Connection* connection;
+        bool is_failed;
+    };
+
+    struct Task {
+        Connection* connection;
+        rpc::Message request;
+    };
+
+    const SearchServer& search_server_;
+    const ShardServiceOptions options_;
+    // Запись в wake_fds_[1] прерывает poll: так Stop и рабочие потоки будят цикл Serve
+    int wake_fds_[2] = {-1, -1};
+    std::atomic<bool> is_stopped_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable task_condition_;
+    std::deque<Task> tasks_;
+    // Соединения, на запросы которых уже отправлен ответ, и удалось ли его отправить
+    std::vector<FinishedRequest> finished_requests_;
+    bool is_shutting_down_ = false;
+
+    // Передаёт рабочим потокам очередной полностью полученный запрос соединения
+    bool DispatchRequest(Connection& connection);
+    void RunWorker();
+    void Wake();
+};
@@ -0,0 +1,29 @@
+#include "stop_words.h"
+
+StopWords::StopWords(const std::set<std::string>& words) {
+    if (words.empty()) {
+        return;
+    }
+    const std::vector<std::string_view> word_views(words.begin(), words.end());
+    std::vector<uint32_t> displacements(perfect_hash::GetBucketCount(word_views.size()));
+    std::vector<size_t> bucket_heads(displacements.size());
+    std::vector<size_t> next_in_bucket(word_views.size());
+    std::vector<size_t> slots;
+    // При неудаче таблица увеличивается: чем она свободнее, тем легче подобрать смещения
+    for (size_t table_size = perfect_hash::GetTableSize(word_views.size()); ; table_size *= 2) {
+        slots.assign(table_size, 0);
+        if (perfect_hash::Build(word_views, word_views.size(), displacements, displacements.size(),
+                                slots, table_size, bucket_heads, next_in_bucket)) {
+            break;
+        }
+    }
+    Assign(word_views, displacements, slots);
+}
+
+size_t StopWords::GetCount() const {
+    size_t count = 0;
+    for (const SlotWord& slot : slot_words_) {
+        count += slot.length > 0;
+    }
+    return count;
+}
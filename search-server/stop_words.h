@@ -0,0 +1,212 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Множество стоп-слов на совершенной хеш-функции: проверка без выделения памяти.
+// MakeStaticStopWords строит таблицу на этапе компиляции
+
+namespace perfect_hash {
+
+constexpr uint64_t Hash(std::string_view word, uint64_t seed) {
+    uint64_t hash = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+    for (const char c : word) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    hash ^= hash >> 32;
+    hash *= 0xD6E8FEB86659FD93ull;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+constexpr size_t GetBucketCount(size_t word_count) {
+    return word_count / 2 + 1;
+}
+
+constexpr size_t GetTableSize(size_t word_count) {
+    size_t size = 1;
+    while (size < 2 * word_count) {
+        size *= 2;
+    }
+    return size;
+}
+
+constexpr uint32_t MAX_DISPLACEMENT = 1u << 20;
+
+// Заполняет displacements (bucket_count элементов) и slots (table_size элементов,
+// номер слова + 1 или 0 для пустой ячейки). Слова должны быть различными.
+// bucket_heads (bucket_count) и next_in_bucket (word_count) — рабочая память.
+// Контейнеры передаются параметрами, чтобы функция работала и с std::array
+// во время компиляции, и с std::vector во время выполнения.
+template <typename Words, typename Displacements, typename Slots, typename Heads, typename Next>
+constexpr bool Build(const Words& words, size_t word_count, Displacements& displacements, size_t bucket_count,
+                     Slots& slots, size_t table_size, Heads& bucket_heads, Next& next_in_bucket) {
+    for (size_t i = 0; i < bucket_count; ++i) {
+        bucket_heads[i] = 0;
+        displacements[i] = 0;
+    }
+    for (size_t i = 0; i < table_size; ++i) {
+        slots[i] = 0;
+    }
+    size_t max_bucket_size = 0;
+    for (size_t i = 0; i < word_count; ++i) {
+        const size_t bucket = Hash(words[i], 0) % bucket_count;
+        next_in_bucket[i] = bucket_heads[bucket];
+        bucket_heads[bucket] = i + 1;
+        size_t bucket_size = 0;
+        for (size_t word = bucket_heads[bucket]; word != 0; word = next_in_bucket[word - 1]) {
+            ++bucket_size;
+        }
+        max_bucket_size = bucket_size > max_bucket_size ? bucket_size : max_bucket_size;
+    }
+    // Большие корзины размещаются первыми, пока таблица свободна
+    for (size_t size = max_bucket_size; size > 0; --size) {
+        for (size_t bucket = 0; bucket < bucket_count; ++bucket) {
+            size_t bucket_size = 0;
+            for (size_t word = bucket_heads[bucket]; word != 0; word = next_in_bucket[word - 1]) {
+                ++bucket_size;
+            }
+            if (bucket_size != size) {
+                continue;
+            }
+            bool is_placed = false;
+            for (uint32_t displacement = 1; displacement < MAX_DISPLACEMENT && !is_placed; ++displacement) {
+                is_placed = true;
+                for (size_t word = bucket_heads[bucket]; word != 0 && is_placed; word = next_in_bucket[word - 1]) {
+                    const size_t slot = Hash(words[word - 1], displacement) % table_size;
+                    if (slots[slot] != 0) {
+                        is_placed = false;
+                    }
+                    for (size_t other = bucket_heads[bucket]; other != word && is_placed; other = next_in_bucket[other - 1]) {
+                        is_placed = Hash(words[other - 1], displacement) % table_size != slot;
+                    }
+                }
+                if (is_placed) {
+                    displacements[bucket] = displacement;
+                    for (size_t word = bucket_heads[bucket]; word != 0; word = next_in_bucket[word - 1]) {
+                        slots[Hash(words[word - 1], displacement) % table_size] = word;
+                    }
+                }
+            }
+            if (!is_placed) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+template <size_t N>
+class StaticStopWords {
+public:
+    static constexpr size_t BUCKET_COUNT = perfect_hash::GetBucketCount(N);
+    static constexpr size_t TABLE_SIZE = perfect_hash::GetTableSize(N);
+
+    constexpr explicit StaticStopWords(const std::array<std::string_view, N>& words)
+        : words_(words) {
+        std::array<size_t, BUCKET_COUNT> bucket_heads{};
+        std::array<size_t, N == 0 ? 1 : N> next_in_bucket{};
+        if (!perfect_hash::Build(words_, N, displacements_, BUCKET_COUNT, slots_, TABLE_SIZE, bucket_heads, next_in_bucket)) {
+            throw std::logic_error("Не удалось построить совершенную хеш-функцию для стоп-слов");
+        }
+    }
+
+    constexpr bool Contains(std::string_view word) const {
+        const uint32_t displacement = displacements_[perfect_hash::Hash(word, 0) % BUCKET_COUNT];
+        const size_t slot = slots_[perfect_hash::Hash(word, displacement) % TABLE_SIZE];
+        return slot != 0 && words_[slot - 1] == word;
+    }
+
+    constexpr const std::array<std::string_view, N>& GetWords() const {
+        return words_;
+    }
+
+    constexpr const std::array<uint32_t, BUCKET_COUNT>& GetDisplacements() const {
+        return displacements_;
+    }
+
+    constexpr const std::array<size_t, TABLE_SIZE>& GetSlots() const {
+        return slots_;
+    }
+
+private:
+    std::array<std::string_view, N> words_;
+    std::array<uint32_t, BUCKET_COUNT> displacements_{};
+    std::array<size_t, TABLE_SIZE> slots_{};
+};
+
+// Слова должны быть непустыми и различными
+template <size_t N>
+constexpr StaticStopWords<N> MakeStaticStopWords(const std::array<std::string_view, N>& words) {
+    return StaticStopWords<N>(words);
+}
+
+class StopWords {
+public:
+    StopWords() = default;
+    explicit StopWords(const std::set<std::string>& words);
+
+    template <size_t N>
+    explicit StopWords(const StaticStopWords<N>& static_words);
+
+    bool Contains(std::string_view word) const {
+        if (slot_words_.empty() || (word.size() < 64 && !((length_mask_ >> word.size()) & 1))) {
+            return false;
+        }
+        const uint32_t displacement = displacements_[perfect_hash::Hash(word, 0) % displacements_.size()];
+        const SlotWord& slot = slot_words_[perfect_hash::Hash(word, displacement) % slot_words_.size()];
+        return slot.length == word.size() && std::string_view(chars_.data() + slot.offset, slot.length) == word;
+    }
+
+    size_t GetCount() const;
+
+private:
+    // Слово ячейки хранится как смещение в chars_, чтобы копирование StopWords
+    // не оставляло ссылок на чужую память. Пустая ячейка имеет длину 0.
+    struct SlotWord {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    std::string chars_;
+    std::vector<uint32_t> displacements_;
+    std::vector<SlotWord> slot_words_;
+    // Бит i установлен, если есть стоп-слово длины i; слова длиннее 63 символов всегда проверяются по таблице
+    uint64_t length_mask_ = 0;
+
+    template <typename Words>
+    void Assign(const Words& words, const std::vector<uint32_t>& displacements, const std::vector<size_t>& slots);
+};
+
+template <typename Words>
+void StopWords::Assign(const Words& words, const std::vector<uint32_t>& displacements, const std::vector<size_t>& slots) {
+    displacements_ = displacements;
+    slot_words_.assign(slots.size(), SlotWord{});
+    chars_.clear();
+    length_mask_ = 0;
+    for (size_t slot = 0; slot < slots.size(); ++slot) {
+        if (slots[slot] == 0) {
+            continue;
+        }
+        const std::string_view word = words[slots[slot] - 1];
+        slot_words_[slot] = {static_cast<uint32_t>(chars_.size()), static_cast<uint32_t>(word.size())};
+        chars_ += word;
+        length_mask_ |= word.size() < 64 ? uint64_t(1) << word.size() : 0;
+    }
+}
+
+template <size_t N>
+StopWords::StopWords(const StaticStopWords<N>& static_words) {
+    const auto& displacements = static_words.GetDisplacements();
+    const auto& slots = static_words.GetSlots();
+    Assign(static_words.GetWords(), std::vector<uint32_t>(displacements.begin(), displacements.end()),
+           std::vector<size_t>(slots.begin(), slots.end()));
+}
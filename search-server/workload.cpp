@@ -0,0 +1,151 @@
+#include "search_server.h"
+#include "random_generators.h"
+#include "instrumentation.h"
+#include "command_line.h"
+#include "corpus_io.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Генерация корпусов и журналов запросов и их воспроизведение:
+//  workload corpus --documents=100000 --vocabulary=50000 > corpus.tsv
+//  workload queries --queries=100000 --vocabulary=50000 > queries.txt
+//  workload replay --corpus=corpus.tsv --queries=queries.txt --qps=2000 --threads=8
+
+vector<string> MakeDictionary(mt19937& generator, const CommandLineOptions& options) {
+    return GenerateDictionary(generator, options.Get("vocabulary"s, 50'000), options.Get("max-word-length"s, 10));
+}
+
+void GenerateCorpusCommand(const CommandLineOptions& options) {
+    mt19937 generator(options.Get("seed"s, mt19937::default_seed));
+    const vector<string> dictionary = MakeDictionary(generator, options);
+    ZipfDistribution word_distribution(dictionary.size(), options.Get("zipf"s, 1.0));
+    const vector<string> documents = GenerateDocuments(generator, dictionary, word_distribution,
+        options.Get("documents"s, 100'000), options.Get("median-words"s, 150), options.Get("length-sigma"s, 0.8));
+    const double actual_fraction = options.Get("actual-fraction"s, 0.5);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const bool is_actual = uniform_real_distribution<>(0, 1)(generator) < actual_fraction;
+        const DocumentStatus status = is_actual ? DocumentStatus::ACTUAL : DocumentStatus::IRRELEVANT;
+        cout << i << '\t' << static_cast<int>(status) << '\t'
+             << uniform_int_distribution(-10, 10)(generator) << ',' << uniform_int_distribution(-10, 10)(generator) << '\t'
+             << documents[i] << '\n';
+    }
+}
+
+void GenerateQueriesCommand(const CommandLineOptions& options) {
+    // Словарь строится из того же зерна, что и в команде corpus, поэтому слова совпадают
+    mt19937 generator(options.Get("seed"s, mt19937::default_seed));
+    const vector<string> dictionary = MakeDictionary(generator, options);
+    ZipfDistribution word_distribution(dictionary.size(), options.Get("zipf"s, 1.0));
+    mt19937 query_generator(options.Get("query-seed"s, mt19937::default_seed + 1));
+    QueryLogParams params;
+    params.query_count = options.Get("queries"s, params.query_count);
+    params.head_query_count = options.Get("head-queries"s, params.head_query_count);
+    params.head_fraction = options.Get("head-fraction"s, params.head_fraction);
+    params.head_exponent = options.Get("head-zipf"s, params.head_exponent);
+    params.max_word_count = options.Get("max-query-words"s, params.max_word_count);
+    params.mean_word_count = options.Get("mean-query-words"s, params.mean_word_count);
+    params.minus_prob = options.Get("minus-prob"s, params.minus_prob);
+    for (const string& query : GenerateQueryLog(query_generator, dictionary, word_distribution, params)) {
+        cout << query << '\n';
+    }
+}
+
+void ReplayCommand(const CommandLineOptions& options) {
+    using Clock = chrono::steady_clock;
+
+    SearchServer search_server(options.GetString("stop-words"s, ""s), ParseRankingFunction(options.GetString("ranking"s, "tf-idf"s)));
+    LoadCorpus(search_server, options.GetString("corpus"s, "corpus.tsv"s));
+    const vector<string> queries = LoadQueries(options.GetString("queries"s, "queries.txt"s));
+    const double qps = options.Get("qps"s, 1000.0);
+    const int thread_count = options.Get("threads"s, static_cast<int>(max(1u, thread::hardware_concurrency())));
+    const bool poisson = options.GetString("arrivals"s, "poisson"s) == "poisson"s;
+
+    // Моменты отправки рассчитываются заранее: равномерно или как пуассоновский поток
+    vector<Clock::duration> schedule(queries.size());
+    mt19937 generator(options.Get("seed"s, mt19937::default_seed));
+    exponential_distribution<> interval(qps);
+    double offset = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        schedule[i] = chrono::duration_cast<Clock::duration>(chrono::duration<double>(offset));
+        offset += poisson ? interval(generator) : 1.0 / qps;
+    }
+
+    Instrumentation::Reset();
+    vector<HdrHistogram> latencies(thread_count);
+    vector<HdrHistogram> service_times(thread_count);
+    atomic<size_t> next_query = 0;
+    atomic<size_t> failed_count = 0;
+    const Clock::time_point start_time = Clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < thread_count; ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t i = next_query++; i < queries.size(); i = next_query++) {
+                const Clock::time_point scheduled = start_time + schedule[i];
+                this_thread::sleep_until(scheduled);
+                const Clock::time_point begin = Clock::now();
+                try {
+                    search_server.FindTopDocuments(queries[i]);
+                } catch (const exception&) {
+                    // Некорректный запрос журнала не должен прерывать воспроизведение
+                    ++failed_count;
+                }
+                const Clock::time_point end = Clock::now();
+                latencies[t].Add(chrono::duration_cast<chrono::nanoseconds>(end - scheduled).count());
+                service_times[t].Add(chrono::duration_cast<chrono::nanoseconds>(end - begin).count());
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    const double elapsed = chrono::duration<double>(Clock::now() - start_time).count();
+
+    HdrHistogram latency;
+    HdrHistogram service_time;
+    for (int t = 0; t < thread_count; ++t) {
+        latency.Merge(latencies[t]);
+        service_time.Merge(service_times[t]);
+    }
+    const auto print_histogram = [](const string& name, const HdrHistogram& histogram) {
+        cout << ", \""s << name << "\": {\"p50_ns\": "s << histogram.GetValueAtPercentile(50)
+             << ", \"p90_ns\": "s << histogram.GetValueAtPercentile(90)
+             << ", \"p99_ns\": "s << histogram.GetValueAtPercentile(99)
+             << ", \"p999_ns\": "s << histogram.GetValueAtPercentile(99.9)
+             << ", \"max_ns\": "s << histogram.GetMax() << '}';
+    };
+    cout << "{\"queries\": "s << queries.size() << ", \"failed\": "s << failed_count << ", \"threads\": "s << thread_count
+         << ", \"target_qps\": "s << qps << ", \"achieved_qps\": "s << queries.size() / elapsed;
+    print_histogram("latency"s, latency);
+    print_histogram("service_time"s, service_time);
+    cout << ", \"instrumentation\": "s;
+    PrintSnapshot(cout, Instrumentation::GetSnapshot());
+    cout << '}' << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc < 2) {
+            throw invalid_argument("Использование: workload corpus|queries|replay [--name=value...]"s);
+        }
+        const string command = argv[1];
+        const CommandLineOptions options(argc, argv, 2);
+        if (command == "corpus"s) {
+            GenerateCorpusCommand(options);
+        } else if (command == "queries"s) {
+            GenerateQueriesCommand(options);
+        } else if (command == "replay"s) {
+            ReplayCommand(options);
+        } else {
+            throw invalid_argument("Неизвестная команда: "s + command);
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,297 @@
+#include "write_ahead_log.h"
+
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "binary_io.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+const std::string SEGMENT_PREFIX = "wal-"s;
+const std::string SEGMENT_SUFFIX = ".log"s;
+constexpr size_t RECORD_HEADER_SIZE = 8;
+// Самая короткая запись — REMOVE_DOCUMENT: номер, тип и id документа
+constexpr size_t MIN_PAYLOAD_SIZE = sizeof(uint64_t) + sizeof(uint8_t) + sizeof(int32_t);
+
+std::string MakeSegmentPath(const std::string& directory, uint64_t first_lsn) {
+    std::ostringstream path;
+    path << directory << '/' << SEGMENT_PREFIX << std::setw(20) << std::setfill('0') << first_lsn << SEGMENT_SUFFIX;
+    return path.str();
+}
+
+std::map<uint64_t, std::string> ListSegments(const std::string& directory) {
+    std::map<uint64_t, std::string> segments;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() <= SEGMENT_PREFIX.size() + SEGMENT_SUFFIX.size()
+                || name.compare(0, SEGMENT_PREFIX.size(), SEGMENT_PREFIX) != 0
+                || name.compare(name.size() - SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX) != 0) {
+            continue;
+        }
+        const std::string number = name.substr(SEGMENT_PREFIX.size(), name.size() - SEGMENT_PREFIX.size() - SEGMENT_SUFFIX.size());
+        if (number.find_first_not_of("0123456789"s) == std::string::npos) {
+            segments.emplace(std::stoull(number), entry.path().string());
+        }
+    }
+    return segments;
+}
+
+void EncodeRecord(std::string& out, const LogRecord& record) {
+    BinaryWriter payload;
+    payload.WriteUint64(record.lsn).WriteUint8(static_cast<uint8_t>(record.type)).WriteInt32(record.document_id);
+    if (record.type == LogRecordType::ADD_DOCUMENT) {
+        payload.WriteUint8(static_cast<uint8_t>(record.status)).WriteUint32(static_cast<uint32_t>(record.ratings.size()));
+        for (const int rating : record.ratings) {
+            payload.WriteInt32(rating);
+        }
+        payload.WriteString(record.text);
+    }
+    BinaryWriter header;
+    header.WriteUint32(static_cast<uint32_t>(payload.GetData().size())).WriteUint32(ComputeCrc32(payload.GetData()));
+    out += header.GetData();
+    out += payload.GetData();
+}
+
+LogRecord DecodeRecord(std::string_view payload) {
+    BinaryReader reader(payload);
+    LogRecord record;
+    record.lsn = reader.ReadUint64();
+    record.type = static_cast<LogRecordType>(reader.ReadUint8());
+    record.document_id = reader.ReadInt32();
+    if (record.type == LogRecordType::ADD_DOCUMENT) {
+        const uint8_t status = reader.ReadUint8();
+        if (status >= DOCUMENT_STATUSES_COUNT) {
+            throw std::runtime_error("Некорректный статус документа в записи журнала"s);
+        }
+        record.status = static_cast<DocumentStatus>(status);
+        record.ratings.resize(reader.ReadCount(sizeof(int32_t)));
+        for (int& rating : record.ratings) {
+            rating = reader.ReadInt32();
+        }
+        record.text = reader.ReadString();
+    } else if (record.type != LogRecordType::REMOVE_DOCUMENT) {
+        throw std::runtime_error("Неизвестный тип записи журнала"s);
+    }
+    if (!reader.IsEnd()) {
+        throw std::runtime_error("Лишние данные в записи журнала"s);
+    }
+    return record;
+}
+
+struct SegmentContent {
+    std::vector<LogRecord> records;
+    // Размер части сегмента, состоящей из целых записей
+    uint64_t valid_size = 0;
+};
+
+// Целая запись с номером не меньше min_lsn, начинающаяся по смещению offset
+bool IsRecordAt(std::string_view data, size_t offset, uint64_t min_lsn) {
+    if (data.size() - offset < RECORD_HEADER_SIZE + MIN_PAYLOAD_SIZE) {
+        return false;
+    }
+    const uint32_t payload_size = DecodeUint32(data.substr(offset));
+    if (payload_size < MIN_PAYLOAD_SIZE || data.size() - offset - RECORD_HEADER_SIZE < payload_size) {
+        return false;
+    }
+    const std::string_view payload = data.substr(offset + RECORD_HEADER_SIZE, payload_size);
+    // Номер проверяется до CRC, чтобы не считать CRC почти по каждому смещению мусора
+    BinaryReader reader(payload);
+    const uint64_t lsn = reader.ReadUint64();
+    const uint64_t max_lsn = min_lsn + (data.size() - offset) / (RECORD_HEADER_SIZE + MIN_PAYLOAD_SIZE);
+    if (lsn < min_lsn || lsn > max_lsn || ComputeCrc32(payload) != DecodeUint32(data.substr(offset + 4))) {
+        return false;
+    }
+    try {
+        DecodeRecord(payload);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+    return true;
+}
+
+// Читает целые записи сегмента до первой повреждённой. Если за ней есть целая
+// запись, повреждение не может быть оборванной при сбое записью в конце журнала,
+// и сегмент считается испорченным
+SegmentContent ParseSegment(std::string_view data, const std::string& path, uint64_t first_lsn) {
+    SegmentContent content;
+    size_t offset = 0;
+    while (data.size() - offset >= RECORD_HEADER_SIZE) {
+        const uint32_t payload_size = DecodeUint32(data.substr(offset));
+        const uint32_t crc = DecodeUint32(data.substr(offset + 4));
+        if (data.size() - offset - RECORD_HEADER_SIZE < payload_size) {
+            break;
+        }
+        const std::string_view payload = data.substr(offset + RECORD_HEADER_SIZE, payload_size);
+        if (ComputeCrc32(payload) != crc) {
+            break;
+        }
+        try {
+            content.records.push_back(DecodeRecord(payload));
+        } catch (const std::runtime_error&) {
+            break;
+        }
+        offset += RECORD_HEADER_SIZE + payload_size;
+    }
+    content.valid_size = offset;
+    const uint64_t next_lsn = content.records.empty() ? first_lsn : content.records.back().lsn + 1;
+    for (size_t next_offset = offset + 1; next_offset < data.size(); ++next_offset) {
+        if (IsRecordAt(data, next_offset, next_lsn)) {
+            throw std::runtime_error("Сегмент журнала повреждён: "s + path);
+        }
+    }
+    return content;
+}
+
+}
+
+WriteAheadLog::WriteAheadLog(std::string directory, WriteAheadLogOptions options)
+    : directory_(std::move(directory))
+    , options_(options)
+{
+    segments_ = ListSegments(directory_);
+    if (segments_.empty()) {
+        const std::string path = MakeSegmentPath(directory_, next_lsn_);
+        file_.emplace(path);
+        segments_.emplace(next_lsn_, path);
+        SyncDirectory(directory_);
+    } else {
+        const auto& [first_lsn, path] = *segments_.rbegin();
+        const SegmentContent content = ParseSegment(ReadFile(path), path, first_lsn);
+        next_lsn_ = content.records.empty() ? first_lsn : content.records.back().lsn + 1;
+        file_.emplace(path);
+        // Запись, оборванная при сбое, отбрасывается, чтобы новые записи шли сразу за целыми.
+        // Повреждение, за которым есть целые записи, ParseSegment не отбрасывает, а сообщает
+        if (content.valid_size < file_->GetSize()) {
+            file_->Truncate(content.valid_size);
+            file_->Sync();
+        }
+    }
+    durable_lsn_ = next_lsn_ - 1;
+}
+
+uint64_t WriteAheadLog::Append(LogRecord record) {
+    std::lock_guard guard(mutex_);
+    if (is_failed_) {
+        throw std::runtime_error("Журнал недоступен после ошибки записи"s);
+    }
+    record.lsn = next_lsn_++;
+    if (buffer_.empty()) {
+        buffer_first_lsn_ = record.lsn;
+    }
+    EncodeRecord(buffer_, record);
+    return record.lsn;
+}
+
+void WriteAheadLog::WaitDurable(uint64_t lsn) {
+    std::unique_lock lock(mutex_);
+    if (lsn >= next_lsn_) {
+        throw std::invalid_argument("Запись с таким номером не добавлялась"s);
+    }
+    while (durable_lsn_ < lsn) {
+        if (is_failed_) {
+            throw std::runtime_error("Журнал недоступен после ошибки записи"s);
+        }
+        if (is_flushing_) {
+            durable_condition_.wait(lock);
+        } else {
+            Flush(lock);
+        }
+    }
+}
+
+uint64_t WriteAheadLog::GetLastLsn() const {
+    std::lock_guard guard(mutex_);
+    return next_lsn_ - 1;
+}
+
+uint64_t WriteAheadLog::GetDurableLsn() const {
+    std::lock_guard guard(mutex_);
+    return durable_lsn_;
+}
+
+uint64_t WriteAheadLog::GetSyncCount() const {
+    std::lock_guard guard(mutex_);
+    return sync_count_;
+}
+
+void WriteAheadLog::Truncate(uint64_t lsn) {
+    std::lock_guard guard(file_mutex_);
+    bool is_removed = false;
+    for (auto it = segments_.begin(); std::next(it) != segments_.end() && std::next(it)->first <= lsn;) {
+        std::filesystem::remove(it->second);
+        it = segments_.erase(it);
+        is_removed = true;
+    }
+    if (is_removed) {
+        SyncDirectory(directory_);
+    }
+}
+
+std::vector<LogRecord> WriteAheadLog::ReadRecords(const std::string& directory, uint64_t from_lsn) {
+    const std::map<uint64_t, std::string> segments = ListSegments(directory);
+    std::vector<LogRecord> records;
+    uint64_t expected_lsn = from_lsn;
+    for (auto it = segments.begin(); it != segments.end(); ++it) {
+        const bool is_last = std::next(it) == segments.end();
+        if (!is_last && std::next(it)->first <= from_lsn) {
+            continue;
+        }
+        const std::string data = ReadFile(it->second);
+        SegmentContent content = ParseSegment(data, it->second, it->first);
+        // Оборванной может быть только последняя запись последнего сегмента
+        if (!is_last && content.valid_size != data.size()) {
+            throw std::runtime_error("Сегмент журнала повреждён: "s + it->second);
+        }
+        for (LogRecord& record : content.records) {
+            if (record.lsn < from_lsn) {
+                continue;
+            }
+            if (record.lsn != expected_lsn) {
+                throw std::runtime_error("В журнале нет записей с номерами от "s + std::to_string(expected_lsn));
+            }
+            ++expected_lsn;
+            records.push_back(std::move(record));
+        }
+    }
+    return records;
+}
+
+void WriteAheadLog::Flush(std::unique_lock<std::mutex>& lock) {
+    is_flushing_ = true;
+    const std::string batch = std::move(buffer_);
+    buffer_.clear();
+    const uint64_t first_lsn = buffer_first_lsn_;
+    const uint64_t last_lsn = next_lsn_ - 1;
+    lock.unlock();
+    // Пока пакет пишется на диск, другие потоки добавляют записи в следующий пакет
+    try {
+        WriteBatch(batch, first_lsn);
+    } catch (...) {
+        lock.lock();
+        is_flushing_ = false;
+        is_failed_ = true;
+        durable_condition_.notify_all();
+        throw;
+    }
+    lock.lock();
+    durable_lsn_ = last_lsn;
+    ++sync_count_;
+    is_flushing_ = false;
+    durable_condition_.notify_all();
+}
+
+void WriteAheadLog::WriteBatch(const std::string& batch, uint64_t first_lsn) {
+    std::lock_guard guard(file_mutex_);
+    if (file_->GetSize() >= options_.segment_size) {
+        const std::string path = MakeSegmentPath(directory_, first_lsn);
+        file_.emplace(path);
+        segments_.emplace(first_lsn, path);
+        SyncDirectory(directory_);
+    }
+    file_->Append(batch);
+    file_->Sync();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "document.h"
+#include "file_io.h"
+
+enum class LogRecordType : uint8_t {
+    ADD_DOCUMENT = 1,
+    REMOVE_DOCUMENT,
+};
+
+struct LogRecord {
+    // Номер записи (LSN), назначается журналом
+    uint64_t lsn = 0;
+    LogRecordType type = LogRecordType::ADD_DOCUMENT;
+    int document_id = 0;
+    // Поля ниже заполняются только для ADD_DOCUMENT
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+    std::string text;
+};
+
+struct WriteAheadLogOptions {
+    // Размер, после которого журнал продолжается в новом сегменте
+    uint64_t segment_size = 64u << 20;
+};
+
+// Журнал AddDocument/RemoveDocument из сегментов "wal-<первый номер>.log" с групповой фиксацией.
+// Оборванная запись в конце журнала отбрасывается, повреждение перед целыми записями — исключение
+class WriteAheadLog {
+public:
+    // Каталог должен существовать. Новые записи получают номера после последней целой записи.
+    explicit WriteAheadLog(std::string directory, WriteAheadLogOptions options = {});
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Возвращает номер, назначенный записи
+    uint64_t Append(LogRecord record);
+    // Ждёт, пока все записи с номерами до lsn включительно не окажутся на диске
+    void WaitDurable(uint64_t lsn);
+
+    // Номер последней добавленной записи, 0 — записей не было
+    uint64_t GetLastLsn() const;
+    uint64_t GetDurableLsn() const;
+    // Число вызовов fdatasync, для оценки эффекта групповой фиксации
+    uint64_t GetSyncCount() const;
+
+    // Удаляет сегменты, все записи которых имеют номера меньше lsn.
+    // Текущий сегмент не удаляется.
+    void Truncate(uint64_t lsn);
+
+    // Читает записи с номерами не меньше from_lsn в порядке номеров
+    static std::vector<LogRecord> ReadRecords(const std::string& directory, uint64_t from_lsn);
+
+private:
+    const std::string directory_;
+    const WriteAheadLogOptions options_;
+
+    // Защищает буфер и номера записей
+    mutable std::mutex mutex_;
+    std::condition_variable durable_condition_;
+    std::string buffer_;
+    uint64_t buffer_first_lsn_ = 0;
+    uint64_t next_lsn_ = 1;
+    uint64_t durable_lsn_ = 0;
+    uint64_t sync_count_ = 0;
+    bool is_flushing_ = false;
+    bool is_failed_ = false;
+
+    // Защищает файлы сегментов; захватывается без mutex_
+    std::mutex file_mutex_;
+    // Номер первой записи сегмента -> путь
+    std::map<uint64_t, std::string> segments_;
+    std::optional<AppendFile> file_;
+
+    void Flush(std::unique_lock<std::mutex>& lock);
+    void WriteBatch(const std::string& batch, uint64_t first_lsn);
+};